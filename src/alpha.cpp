@@ -0,0 +1,88 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "alpha.hpp"
+
+Alpha splitAlpha(TBitmap &bitmap, TBitmap &mask, bool channel)
+{
+    const size_t count = (size_t)bitmap.width * bitmap.height;
+    uint8_t *bytes = bitmap.bytes.data();
+    
+    // The mask may be one reused from an earlier image, so any old mask is dropped but its capacity kept.
+    mask.bytes.clear();
+    
+    // Without an alpha channel the fourth byte of each pixel means nothing, even when zero.
+    if (!channel) return AlphaOpaque;
+    
+    /*
+     A pixel is taken as opaque when its alpha is 128 or more. The whole image is
+     scanned first using branch free reductions, which the compiler vectorizes, to
+     find out whether a mask is needed at all.
+     */
+    uint8_t any = 0, all = 1;
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t opaque = bytes[i * 4 + 3] >> 7;
+        any |= opaque;
+        all &= opaque;
+    }
+    
+    if (all) return AlphaOpaque;
+    if (!any) return AlphaTransparent;
+    
+    mask.width = bitmap.width;
+    mask.height = bitmap.height;
+    mask.bpp = 1;
+    mask.palette = { 0x000000FF, 0xFFFFFFFF };
+    mask.bytes.resize(bitmapStride(mask) * mask.height);
+    
+    uint32_t fill = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (bytes[i * 4 + 3] >> 7) {
+            fill = ((uint32_t *)bytes)[i];
+            break;
+        }
+    }
+    
+    size_t stride = bitmapStride(mask);
+    for (int y = 0; y < bitmap.height; ++y) {
+        const uint8_t *row = bytes + (size_t)y * bitmap.width * 4;
+        uint8_t *bits = mask.bytes.data() + stride * y;
+        
+        int x = 0;
+        for (; x + 8 <= bitmap.width; x += 8) {
+            uint8_t byte = 0;
+            for (int k = 0; k < 8; ++k)
+                byte |= (row[(x + k) * 4 + 3] >> 7) << (7 - k);
+            bits[x / 8] = byte;
+        }
+        for (; x < bitmap.width; ++x)
+            bits[x / 8] |= (row[x * 4 + 3] >> 7) << (7 - x % 8);
+    }
+    
+    uint32_t *pixels = (uint32_t *)bytes;
+    for (size_t i = 0; i < count; ++i) {
+        pixels[i] = bytes[i * 4 + 3] >> 7 ? pixels[i] : fill;
+    }
+    
+    return AlphaMasked;
+}
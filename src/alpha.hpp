@@ -0,0 +1,46 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef alpha_hpp
+#define alpha_hpp
+
+#include "bmp.hpp"
+
+enum Alpha {
+    AlphaOpaque,
+    AlphaTransparent,
+    AlphaMasked
+};
+
+/**
+ @brief    Splits the alpha channel of a 32bpp bitmap image into a 1bpp mask, where a set bit
+           marks an opaque pixel. The transparent pixels of the image are given the color of an
+           opaque pixel, so that they add nothing to the colors the image uses.
+ @param    bitmap The 32bpp bitmap image.
+ @param    mask The 1bpp mask, only generated when the image is partly transparent and left empty otherwise.
+ @param    channel Whether the image has an alpha channel at all, an image without one is fully opaque.
+ @return   Whether the image is fully opaque, fully transparent or needs the mask.
+ */
+Alpha splitAlpha(TBitmap &bitmap, TBitmap &mask, bool channel);
+
+#endif /* alpha_hpp */
@@ -22,6 +22,7 @@
 
 #include "bmp.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <string_view>
 
@@ -71,93 +72,193 @@ template <typename T> static T swap_endian(T u) {
 static void flipBitmapImageVertically(const TBitmap& bitmap)
 {
     uint8_t *byte = (uint8_t *)bitmap.bytes.data();
-    int w = (int)((float)bitmap.width / (8.0 / (float)bitmap.bpp));
-    int h = (int)bitmap.height;
+    size_t w = bitmapStride(bitmap);
+    size_t h = bitmap.height;
     
-    for (int row = 0; row < h / 2; ++row)
-        for (int col = 0; col < w; ++col)
+    for (size_t row = 0; row < h / 2; ++row)
+        for (size_t col = 0; col < w; ++col)
             std::swap(byte[col + row * w], byte[col + (h - 1 - row) * w]);
     
 }
 
-TBitmap loadBitmapImage(const std::string& filename)
+/*
+ Reads the header of a bitmap and validates it against the size of the file, so
+ that nothing in the header can cause an allocation or read beyond what the file
+ actually holds. All checks are simple arithmetic, so a malformed file is rejected
+ in constant time whatever its header claims. Returns the size of the file, or
+ zero should the file not be a bitmap this loader supports.
+ */
+static uint64_t readBitmapHeader(std::ifstream &infile, BIPHeader &bip_header)
 {
-    BIPHeader bip_header;
+    infile.seekg(0, std::ios_base::end);
+    uint64_t fileSize = infile.tellg();
+    infile.seekg(0, std::ios_base::beg);
     
-    std::ifstream infile;
+    if (fileSize < sizeof(BIPHeader)) return 0;
     
-    TBitmap bitmap{};
+    infile.read((char *)&bip_header, sizeof(BIPHeader));
+    if (infile.gcount() != sizeof(BIPHeader)) return 0;
     
+    std::string_view type{bip_header.fileHeader.bfType, 2};
+    if (type != "BM") return 0;
     
-    infile.open(filename, std::ios::in | std::ios::binary);
-    if (!infile.is_open()) {
-        return bitmap;
-    }
+    // BITMAPINFOHEADER or one of its later extensions, uncompressed or with bit fields.
+    if (bip_header.biSize < 40 || bip_header.biPlanes != 1) return 0;
+    if (bip_header.biCompression != 0 && bip_header.biCompression != 3) return 0;
     
-    infile.read((char *)&bip_header, sizeof(BIPHeader));
-
-    std::string_view type{bip_header.fileHeader.bfType, 2};
+    int bpp = bip_header.biBitCount;
+    if (bpp != 1 && bpp != 4 && bpp != 8 && bpp != 16 && bpp != 32) return 0;
+    if (bip_header.biCompression == 3 && bpp < 16) return 0;
     
-    if (type != "BM") {
-        infile.close();
-        return bitmap;
-    }
+    int64_t width = bip_header.biWidth, height = bip_header.biHeight;
+    if (height < 0) height = -height;
+    if (width < 1 || width > 0xFFFF || height < 1 || height > 0xFFFF) return 0;
     
-    bitmap.bpp = bip_header.biBitCount;
-    bitmap.bytes.reserve(bip_header.biSizeImage);
-    bitmap.bytes.resize(bip_header.biSizeImage);
-    if (bitmap.bytes.empty()) {
-        infile.close();
-        return bitmap;
-    }
+    // Every scan line is padded to a multiple of 4 bytes.
+    uint64_t stride = ((uint64_t)width * bpp + 31) / 32 * 4;
+    uint64_t offset = bip_header.fileHeader.bfOffBits;
+    if (offset > fileSize || stride * height > fileSize - offset) return 0;
     
     /*
      We verify whether the image data begins immediately after the file header.
      If it does not, we ensure that biClrUsed is set correctly. Some software
      that generates BMP files with a palette may incorrectly set biClrUsed to
      zero, even when a palette is present, and this value needs to be corrected.
+     Only indexed images have a palette, and it may not overlap the image data.
      */
-    if (bip_header.biClrUsed == 0) {
-        if (bip_header.fileHeader.bfOffBits > sizeof(BIPHeader)) {
-            bip_header.biClrUsed = (bip_header.fileHeader.bfOffBits - sizeof(BIPHeader)) / sizeof(uint32_t);
-            bip_header.biClImportant = bip_header.biClrUsed;
+    uint64_t palette = 14 + (uint64_t)bip_header.biSize;
+    if (palette > offset) return 0;
+    
+    if (bpp > 8) {
+        bip_header.biClrUsed = 0;
+    } else {
+        if (bip_header.biClrUsed == 0) {
+            bip_header.biClrUsed = std::min<uint64_t>((offset - palette) / sizeof(uint32_t), 1 << bpp);
         }
+        if (bip_header.biClrUsed > (1u << bpp) || palette + bip_header.biClrUsed * sizeof(uint32_t) > offset) return 0;
     }
+    bip_header.biClImportant = bip_header.biClrUsed;
+    
+    // An image size of zero is valid for uncompressed images, the real size is always used.
+    bip_header.biSizeImage = (uint32_t)(stride * height);
+    
+    return fileSize;
+}
+
+static void readPalette(std::ifstream &infile, const BIPHeader &bip_header, TBitmap &bitmap)
+{
+    bitmap.palette.resize(bip_header.biClrUsed);
+    if (bitmap.palette.empty()) return;
+    
+    infile.seekg(14 + bip_header.biSize, std::ios_base::beg);
+    infile.read((char *)bitmap.palette.data(), bitmap.palette.size() * sizeof(uint32_t));
     
-    if (bip_header.biClrUsed) {
-        for (int i = 0; i < bip_header.biClrUsed; i += 1) {
-            uint32_t color;
-            infile.read((char *)&color, sizeof(uint32_t));
+    for (auto &color : bitmap.palette) {
 #ifdef __LITTLE_ENDIAN__
-            color = swap_endian(color);
+        color = swap_endian(color);
 #endif
-            bitmap.palette.push_back(color | 255);
-        }
+        color |= 255;
     }
+}
+
+bool isBitmapFile(const std::string& filename)
+{
+    char type[2] = {};
+    std::ifstream infile(filename, std::ios::in | std::ios::binary);
     
-    bitmap.palette.resize(bip_header.biClrUsed);
+    infile.read(type, sizeof(type));
+    return std::string_view{type, 2} == "BM";
+}
+
+TBitmapHeader loadBitmapHeader(const std::string& filename)
+{
+    BIPHeader bip_header;
+    TBitmapHeader header{};
+    
+    std::ifstream infile;
+    
+    infile.open(filename, std::ios::in | std::ios::binary);
+    if (!infile.is_open()) {
+        return header;
+    }
+    
+    if (!readBitmapHeader(infile, bip_header)) {
+        return header;
+    }
+    
+    /*
+     Only a 32bpp image may have an alpha channel, and only when an alpha mask is
+     given, either in a BITMAPV3INFOHEADER or later, or as a fourth bit field after
+     a BITMAPINFOHEADER. Either way the mask is found at the same offset. Without
+     one the fourth byte of each pixel is unused, and is most often left as zero.
+     */
+    uint32_t mask = 0;
+    if (bip_header.biBitCount == 32 && (bip_header.biSize >= 56 || (bip_header.biCompression == 3 && bip_header.fileHeader.bfOffBits >= 70))) {
+        infile.seekg(66, std::ios_base::beg);
+        infile.read((char *)&mask, sizeof(mask));
+        if (infile.gcount() != sizeof(mask)) mask = 0;
+    }
+    infile.close();
+    
+    header.alpha = mask != 0;
+    header.width = abs(bip_header.biWidth);
+    header.height = abs(bip_header.biHeight);
+    header.bpp = bip_header.biBitCount;
+    header.colors = bip_header.biClrUsed;
+    
+    return header;
+}
+
+bool loadBitmapImage(const std::string& filename, TBitmap &bitmap)
+{
+    BIPHeader bip_header;
+    
+    std::ifstream infile;
+    
+    // The bitmap may be one reused from an earlier image, its capacity is kept.
+    bitmap.width = bitmap.height = 0;
+    bitmap.bpp = 0;
+    bitmap.bytes.clear();
+    
+    
+    infile.open(filename, std::ios::in | std::ios::binary);
+    if (!infile.is_open()) {
+        return false;
+    }
+    
+    if (!readBitmapHeader(infile, bip_header)) {
+        infile.close();
+        return false;
+    }
+    
+    readPalette(infile, bip_header, bitmap);
     
+    bitmap.bpp = bip_header.biBitCount;
     bitmap.width = abs(bip_header.biWidth);
     bitmap.height = abs(bip_header.biHeight);
-    size_t length = (size_t)((float)bitmap.width / (8.0 / (float)bip_header.biBitCount));
+    
+    /*
+     Each scan line is zero padded to the nearest 4-byte boundary.
+     
+     If the image has a width that is not divisible by four, say, 21 bytes, there
+     would be 3 bytes of padding at the end of every scan line.
+     */
+    size_t length = bitmapStride(bitmap);
+    size_t stride = (length + 3) & ~3;
+    bitmap.bytes.resize(length * bitmap.height);
     uint8_t* bytes = (uint8_t *)bitmap.bytes.data();
     
     infile.seekg(bip_header.fileHeader.bfOffBits, std::ios_base::beg);
     for (int r = 0; r < bitmap.height; ++r) {
         infile.read((char *)&bytes[length * r], length);
-        if (infile.gcount() != length) {
-            std::cout << filename << " Read failed!\n";
+        if (infile.gcount() != (std::streamsize)length) {
+            std::cerr << filename << " Read failed!\n";
+            bitmap.bytes.clear();
             break;
         }
         
-        /*
-         Each scan line is zero padded to the nearest 4-byte boundary.
-         
-         If the image has a width that is not divisible by four, say, 21 bytes, there
-         would be 3 bytes of padding at the end of every scan line.
-         */
-        if (length % 4)
-            infile.seekg(4 - length % 4, std::ios_base::cur);
+        if (stride != length)
+            infile.seekg(stride - length, std::ios_base::cur);
     }
     
     infile.close();
@@ -165,7 +266,167 @@ TBitmap loadBitmapImage(const std::string& filename)
     if (bip_header.biHeight > 0)
         flipBitmapImageVertically(bitmap);
     
+    return !bitmap.bytes.empty();
+}
+
+TBitmap loadBitmapImage(const std::string& filename)
+{
+    TBitmap bitmap{};
+    loadBitmapImage(filename, bitmap);
     return bitmap;
 }
 
+bool loadBitmapImage(const std::string& filename, int x, int y, int width, int height, TBitmap &bitmap)
+{
+    BIPHeader bip_header;
+    
+    std::ifstream infile;
+    
+    // The bitmap may be one reused from an earlier image, its capacity is kept.
+    bitmap.width = bitmap.height = 0;
+    bitmap.bpp = 0;
+    bitmap.bytes.clear();
+    
+    
+    infile.open(filename, std::ios::in | std::ios::binary);
+    if (!infile.is_open()) {
+        return false;
+    }
+    
+    if (!readBitmapHeader(infile, bip_header)) {
+        infile.close();
+        return false;
+    }
+    
+    readPalette(infile, bip_header, bitmap);
+    
+    // The region is clipped to the bounds of the image.
+    int w = abs(bip_header.biWidth), h = abs(bip_header.biHeight);
+    if (x < 0) width += x, x = 0;
+    if (y < 0) height += y, y = 0;
+    width = std::min(width, w - x);
+    height = std::min(height, h - y);
+    if (width <= 0 || height <= 0) {
+        infile.close();
+        return false;
+    }
+    
+    bitmap.bpp = bip_header.biBitCount;
+    bitmap.width = width;
+    bitmap.height = height;
+    
+    /*
+     Only the bytes of each scan line that hold the region are read, and only the
+     scan lines of the region itself, seeking straight to each one in turn. For
+     1bpp and 4bpp images the region may start part way into a byte, so one extra
+     byte is read and the row is shifted into place.
+     
+     Each scan line is read straight into its own row, the extra byte spilling into
+     the start of the next row, or into one spare byte past the end of the image,
+     before the row is shifted into place from left to right.
+     */
+    size_t length = bitmapStride(bitmap);
+    size_t stride = ((size_t)w * bitmap.bpp + 31) / 32 * 4;
+    size_t start = (size_t)x * bitmap.bpp / 8;
+    int shift = (int)((size_t)x * bitmap.bpp % 8);
+    size_t span = std::min(length + (shift ? 1 : 0), stride - start);
+    bitmap.bytes.resize(length * height + 1);
+    
+    for (int r = 0; r < height; ++r) {
+        uint8_t *bytes = bitmap.bytes.data() + length * r;
+        size_t line = bip_header.biHeight > 0 ? h - 1 - (y + r) : y + r;
+        infile.seekg(bip_header.fileHeader.bfOffBits + line * stride + start, std::ios_base::beg);
+        infile.read((char *)bytes, span);
+        if (infile.gcount() != (std::streamsize)span) {
+            std::cerr << filename << " Read failed!\n";
+            bitmap.bytes.clear();
+            break;
+        }
+        
+        if (shift) {
+            for (size_t i = 0; i < length; ++i)
+                bytes[i] = bytes[i] << shift | bytes[i + 1] >> (8 - shift);
+        }
+        
+        // Any bits beyond the last pixel are cleared.
+        int used = (int)((size_t)width * bitmap.bpp % 8);
+        if (used) bytes[length - 1] &= 0xFF << (8 - used);
+    }
+    
+    infile.close();
+    
+    if (!bitmap.bytes.empty()) bitmap.bytes.resize(length * height);
+    return !bitmap.bytes.empty();
+}
+
+TBitmap loadBitmapImage(const std::string& filename, int x, int y, int width, int height)
+{
+    TBitmap bitmap{};
+    loadBitmapImage(filename, x, y, width, height, bitmap);
+    return bitmap;
+}
+
+size_t bitmapStride(const TBitmap &bitmap)
+{
+    return ((size_t)bitmap.width * bitmap.bpp + 7) / 8;
+}
+
+uint32_t getPixel(const TBitmap &bitmap, int x, int y)
+{
+    const uint8_t *row = bitmap.bytes.data() + bitmapStride(bitmap) * y;
+    
+    switch (bitmap.bpp) {
+        case 1:
+            return row[x / 8] >> (7 - x % 8) & 1;
+            
+        case 4:
+            return x & 1 ? row[x / 2] & 15 : row[x / 2] >> 4;
+            
+        case 8:
+            return row[x];
+            
+        case 16:
+            return *(uint16_t *)&row[x * 2];
+            
+        case 32:
+            return *(uint32_t *)&row[x * 4];
+            
+        default:
+            return 0;
+    }
+}
 
+void setPixel(TBitmap &bitmap, int x, int y, uint32_t value)
+{
+    uint8_t *row = bitmap.bytes.data() + bitmapStride(bitmap) * y;
+    
+    switch (bitmap.bpp) {
+        case 1:
+            row[x / 8] &= ~(0x80 >> x % 8);
+            row[x / 8] |= (value & 1) << (7 - x % 8);
+            break;
+            
+        case 4:
+            if (x & 1) {
+                row[x / 2] = (row[x / 2] & 0xF0) | (value & 15);
+            } else {
+                row[x / 2] = (row[x / 2] & 0x0F) | (value & 15) << 4;
+            }
+            break;
+            
+        case 8:
+            row[x] = value;
+            break;
+            
+        case 16:
+            *(uint16_t *)&row[x * 2] = value;
+            break;
+            
+        case 32:
+            *(uint32_t *)&row[x * 4] = value;
+            break;
+            
+        default:
+            break;
+    }
+}
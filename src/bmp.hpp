@@ -38,12 +38,94 @@ typedef struct {
 } TBitmap;
 #endif
 
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint8_t  bpp;
+    uint32_t colors;
+    bool     alpha;
+} TBitmapHeader;
+
+/**
+ @brief    Checks whether a file identifies itself as being in the Bitmap (BMP) format.
+ @param    filename The filename of the file to be examined.
+ @return   true if the file starts with the Bitmap (BMP) signature, valid or not.
+ */
+bool isBitmapFile(const std::string &filename);
+
+/**
+ @brief    Reads only the header of a file in the Bitmap (BMP) format, no image data is loaded.
+ @param    filename The filename of the Bitmap (BMP) to be examined.
+ @return   A structure describing the bitmap image, bpp is zero if the file is not a valid bitmap.
+           alpha is only set for a 32bpp image whose header gives it an alpha mask.
+ */
+TBitmapHeader loadBitmapHeader(const std::string &filename);
+
 /**
  @brief    Loads a file in the Bitmap (BMP) format.
  @param    filename The filename of the Bitmap (BMP) to be loaded.
- @return   A structure containing the bitmap image data.
+ @return   A structure containing the bitmap image data, no image data if the file is not a valid bitmap.
  */
 TBitmap loadBitmapImage(const std::string &filename);
 
+/**
+ @brief    Loads a region of a file in the Bitmap (BMP) format, reading only the scan lines and
+           bytes the region needs.
+ @param    filename The filename of the Bitmap (BMP) to be loaded.
+ @param    x The left edge of the region.
+ @param    y The top edge of the region.
+ @param    width The width of the region.
+ @param    height The height of the region.
+ @return   A structure containing the bitmap image data of the region, clipped to the image.
+ */
+TBitmap loadBitmapImage(const std::string &filename, int x, int y, int width, int height);
+
+/**
+ @brief    Loads a file in the Bitmap (BMP) format into an existing bitmap, reusing the memory
+           it already holds so that loading one image after another need not allocate.
+ @param    filename The filename of the Bitmap (BMP) to be loaded.
+ @param    bitmap The bitmap to load the image into.
+ @return   Whether the file is a valid bitmap, if not the bitmap is left without image data.
+ */
+bool loadBitmapImage(const std::string &filename, TBitmap &bitmap);
+
+/**
+ @brief    Loads a region of a file in the Bitmap (BMP) format into an existing bitmap, reusing
+           the memory it already holds.
+ @param    filename The filename of the Bitmap (BMP) to be loaded.
+ @param    x The left edge of the region.
+ @param    y The top edge of the region.
+ @param    width The width of the region.
+ @param    height The height of the region.
+ @param    bitmap The bitmap to load the region into.
+ @return   Whether the region was loaded, if not the bitmap is left without image data.
+ */
+bool loadBitmapImage(const std::string &filename, int x, int y, int width, int height, TBitmap &bitmap);
+
+/**
+ @brief    Returns the number of bytes used to store a single row of the bitmap image.
+ @param    bitmap The bitmap image.
+ @return   The row length in bytes, rows are not padded beyond the nearest whole byte.
+ */
+size_t bitmapStride(const TBitmap &bitmap);
+
+/**
+ @brief    Returns the value of a single pixel, for indexed images this is the palette index.
+ @param    bitmap The bitmap image.
+ @param    x The column of the pixel.
+ @param    y The row of the pixel.
+ @return   The pixel value.
+ */
+uint32_t getPixel(const TBitmap &bitmap, int x, int y);
+
+/**
+ @brief    Sets the value of a single pixel, for indexed images this is the palette index.
+ @param    bitmap The bitmap image.
+ @param    x The column of the pixel.
+ @param    y The row of the pixel.
+ @param    value The pixel value.
+ */
+void setPixel(TBitmap &bitmap, int x, int y, uint32_t value);
+
 
 #endif /* bmp_hpp */
@@ -0,0 +1,90 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include "font.hpp"
+
+#include <algorithm>
+
+/*
+ Finds the bounds of the ink within a cell, the glyph being left without a size
+ should the cell be blank.
+ */
+static TGlyph trimGlyph(const TBitmap &bitmap, int left, int top, int width, int height)
+{
+    TGlyph glyph{};
+    int x0 = width, y0 = height, x1 = -1, y1 = -1;
+    
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (!getPixel(bitmap, left + x, top + y)) continue;
+            x0 = std::min(x0, x);
+            x1 = std::max(x1, x);
+            y0 = std::min(y0, y);
+            y1 = std::max(y1, y);
+        }
+    }
+    
+    if (x1 < 0) return glyph;
+    
+    glyph.x = x0;
+    glyph.y = y0;
+    glyph.width = x1 - x0 + 1;
+    glyph.height = y1 - y0 + 1;
+    return glyph;
+}
+
+TFont buildFont(const TBitmap &bitmap, int columns, int rows)
+{
+    TFont font{};
+    
+    if (bitmap.bpp != 1 || columns < 1 || rows < 1) return font;
+    
+    font.width = bitmap.width / columns;
+    font.height = bitmap.height / rows;
+    if (!font.width || !font.height || font.width > 255 || font.height > 255) return font;
+    
+    /*
+     Glyphs are trimmed and packed in order, each one starting at the bit straight
+     after the last pixel of the glyph before it, a row of the glyph at a time.
+     */
+    size_t offset = 0;
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            int left = column * font.width, top = row * font.height;
+            TGlyph glyph = trimGlyph(bitmap, left, top, font.width, font.height);
+            glyph.offset = (uint32_t)offset;
+            
+            font.bits.resize((offset + glyph.width * glyph.height + 63) / 64);
+            for (int y = 0; y < glyph.height; ++y) {
+                for (int x = 0; x < glyph.width; ++x, ++offset) {
+                    if (getPixel(bitmap, left + glyph.x + x, top + glyph.y + y))
+                        font.bits[offset / 64] |= 1ULL << (offset % 64);
+                }
+            }
+            font.glyphs.push_back(glyph);
+        }
+    }
+    
+    return font;
+}
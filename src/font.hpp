@@ -0,0 +1,55 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef font_hpp
+#define font_hpp
+
+#include "bmp.hpp"
+
+typedef struct {
+    uint32_t offset;
+    uint8_t x, y;
+    uint8_t width, height;
+} TGlyph;
+
+typedef struct {
+    uint16_t width, height;
+    std::vector<uint64_t> bits;
+    std::vector<TGlyph> glyphs;
+} TFont;
+
+/**
+ @brief    Slices a 1bpp font sheet into a grid of glyph cells, trims each glyph to the bounds of
+           its ink, a set pixel, and packs the trimmed glyphs one after another into a bitstream.
+ @param    bitmap The 1bpp font sheet, its glyphs ordered left to right, then top to bottom.
+ @param    columns The number of glyph cells across the sheet.
+ @param    rows The number of glyph cells down the sheet.
+ @return   The size of a cell, the bitstream, where bit n is bit n % 64 of element n / 64, and for
+           each glyph the offset in bits of its first pixel, with its position and size within
+           its cell. A glyph without ink has no size. No glyphs if the sheet is not 1bpp or if a
+           cell would be larger than 255 pixels across.
+ */
+TFont buildFont(const TBitmap &bitmap, int columns, int rows);
+
+#endif /* font_hpp */
@@ -24,20 +24,42 @@
 #include <fstream>
 #include <sstream>
 #include <filesystem>
-#include <regex>
 #include <cstring>
 #include <iomanip>
 #include <cstdint>
+#include <charconv>
+#include <mutex>
 #include "utf.hpp"
 
 #include "../version_code.h"
 #include "bmp.hpp"
+#include "palette.hpp"
+#include "parallel.hpp"
+#include "tiles.hpp"
+#include "alpha.hpp"
+#include "scale.hpp"
+#include "orient.hpp"
+#include "font.hpp"
 
 #define NAME "GROB"
 #define COMMAND_NAME "grob"
 
 // MARK: - Functions
 
+static std::mutex statusMutex;
+
+/*
+ Writes a status message to stderr as a whole, as images may be converted on
+ several threads at once and a message written a part at a time could be split
+ by a message from another thread.
+ */
+template <typename... T> static void status(const T &...parts) {
+    std::ostringstream os;
+    (os << ... << parts);
+    std::lock_guard<std::mutex> lock(statusMutex);
+    std::cerr << os.str();
+}
+
 template <typename T>
 T swap_endian(T u)
 {
@@ -57,40 +79,62 @@ T swap_endian(T u)
     return dest.u;
 }
 
+/*
+ Appends a number as a fixed number of uppercase hexadecimal digits, or in
+ decimal, directly to the end of the output. Unlike formatting with a stream,
+ nothing is allocated once the output has grown large enough.
+ */
+static void appendHex(std::string &out, uint64_t n, int digits) {
+    static const char hex[] = "0123456789ABCDEF";
+    size_t length = out.size();
+    out.resize(length + digits);
+    for (int i = digits - 1; i >= 0; --i, n >>= 4) {
+        out[length + i] = hex[n & 15];
+    }
+}
+
+static void appendDecimal(std::string &out, size_t n) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), n);
+    out.append(digits, result.ptr);
+}
+
+// Appends a single 64-bit element of a list in the byte order requested.
+static void pplWord(std::string &out, uint64_t n, bool le) {
+    if (!le) {
+        n = swap_endian<uint64_t>(n);
+    }
+    
+#ifndef __LITTLE_ENDIAN__
+    /*
+     This platform utilizes big-endian, not little-endian. To ensure
+     that data is processed correctly when generating the list, we
+     must convert between big-endian and little-endian.
+     */
+    if (le) n = swap_endian<uint64_t>(n);
+#endif
+
+    out.append("#");
+    appendHex(out, n, 16);
+    out.append(":64h");
+}
+
 // A list is limited to 10,000 elements. Attempting to create a longer list will result in error 38 (Insufficient memory) being thrown.
-static std::string ppl(const void *data, const size_t lengthInBytes, const int columns, bool le = true) {
-    std::ostringstream os;
-    uint64_t n;
+static void ppl(std::string &out, const void *data, const size_t lengthInBytes, const int columns, bool le = true) {
     size_t count = 0;
     size_t length = lengthInBytes;
     uint64_t *bytes = (uint64_t *)data;
     
     while (length >= 8) {
-        n = *bytes++;
-        
-        if (!le) {
-            n = swap_endian<uint64_t>(n);
-        }
-        
-#ifndef __LITTLE_ENDIAN__
-        /*
-         This platform utilizes big-endian, not little-endian. To ensure
-         that data is processed correctly when generating the list, we
-         must convert between big-endian and little-endian.
-         */
-        if (le) n = swap_endian<uint64_t>(n);
-#endif
-
-        if (count) os << ", ";
+        if (count) out.append(", ");
         if (count % columns == 0) {
-            os << (count ? "\n    " : "    ");
+            out.append(count ? "\n    " : "    ");
         }
-        os << "#" << std::uppercase << std::hex << std::setfill('0') << std::setw(16) << n << ":64h";
+        pplWord(out, *bytes++, le);
         
         count += 1;
         length -= 8;
     }
-    return os.str();
 }
 
 static std::ifstream::pos_type filesize(const char* filename)
@@ -131,6 +175,378 @@ std::string expandTilde(const std::string &path) {
 }
 
 
+// A 1bpp image is always listed as black ink, a set bit, on white.
+static void monochromePalette(TBitmap &bitmap) {
+    if (bitmap.bpp == 1) bitmap.palette.assign({ 0xFFFFFFFF, 0xFF });
+}
+
+/*
+ Returns the length in bytes of the pixel data listed for an image of the given
+ size and bpp, and sets the number of columns best suited to its bpp, or returns
+ zero for an unsupported bpp. Shared by the conversion and the dry run, so that
+ the sizes projected always follow the layout actually listed.
+ */
+static size_t listLayout(size_t width, size_t height, int bpp, int &columns) {
+    size_t lengthInBytes = 0;
+    
+    switch (bpp) {
+        case 1:
+            lengthInBytes = width * height / 8;
+            columns = (int)(width / 64);
+            break;
+            
+        case 4:
+            lengthInBytes = width * height / 2;
+            columns = (int)(width / 16);
+            break;
+            
+        case 8:
+            lengthInBytes = width * height;
+            columns = (int)(width / 8);
+            break;
+            
+        case 16:
+            lengthInBytes = width * height * 2;
+            break;
+            
+        case 32:
+            lengthInBytes = width * height * 4;
+            break;
+            
+        default:
+            return 0;
+    }
+    
+    if (columns < 1) columns = 1;
+    return lengthInBytes;
+}
+
+/*
+ Converts the pixel data of a loaded bitmap image in place to the order the HP
+ Prime expects, and sets the number of columns best suited to its bpp. Returns
+ the length in bytes of the data to be listed, or zero for an unsupported bpp.
+ */
+static size_t convertBitmap(TBitmap &bitmap, int &columns, bool le) {
+    if (bitmap.bpp == 0) {
+        if (columns < 1) columns = 1;
+        return bitmap.bytes.size();
+    }
+    
+    size_t lengthInBytes = listLayout(bitmap.width, bitmap.height, bitmap.bpp, columns);
+    if (bitmap.bytes.empty()) return lengthInBytes;
+    
+    uint8_t *bytes = (uint8_t *)bitmap.bytes.data();
+    switch (bitmap.bpp) {
+        case 1:
+            for (size_t i = 0; i < lengthInBytes; i += 1) {
+                uint8_t result = 0;
+                for (int n = 0; n < 8; n += 1) {
+                    result <<= 1;
+                    result |= bytes[i] & 1;
+                    bytes[i] >>= 1;
+                }
+                bytes[i] = result;
+            }
+            break;
+            
+        case 4:
+            if (le) {
+                /*
+                 Due to the use of little-endian format, when the 8-byte sequence
+                 is interpreted as a single 64-bit number, the bytes are stored in
+                 reverse order (from least significant to most significant).
+                 Since this data represents an image where each nibble corresponds
+                 to an index, we must first swap the nibbles in the entire data
+                 sequence to ensure they remain in the correct order when read from
+                 right to left.
+                 */
+                for (size_t i = 0; i < lengthInBytes; i += 1) {
+                    // Swap nibbles
+                    bytes[i] = bytes[i] >> 4 | bytes[i] << 4;
+                }
+            }
+            break;
+    }
+    
+    return lengthInBytes;
+}
+
+// Appends the colors of a palette, sixteen to a line.
+static void pplPalette(std::string &out, const std::vector<uint32_t> &palette) {
+    out.append("    ");
+    for (int i = 0; i < palette.size(); i += 1) {
+        uint32_t color = palette.at(i);
+#ifdef __LITTLE_ENDIAN__
+        color = swap_endian(color);
+#endif
+        color &= 0xFFFFFF;
+        if (i) out.append(", ");
+        if (i % 16 == 0 && i) out.append("\n    ");
+        out.append("#");
+        appendHex(out, color, 6);
+        out.append(":32h");
+    }
+}
+
+// Appends the size and bpp of an image, as the second list of a graphic object.
+static void pplSize(std::string &out, const TBitmap &bitmap) {
+    out.append("  { ");
+    appendDecimal(out, bitmap.width);
+    out.append(", ");
+    appendDecimal(out, bitmap.height);
+    out.append(", ");
+    appendDecimal(out, bitmap.bpp);
+    out.append(" }");
+}
+
+/*
+ Appends the PPL list for a loaded bitmap image, or for raw binary data when bpp
+ is zero, to the output. The pixel data is converted in place to the order the
+ HP Prime expects, and false is returned for an unsupported bpp.
+ 
+ When the name of a shared palette is given, the color table of an indexed image
+ is left out, and the shared palette is appended to the image when it is drawn.
+ */
+static bool grobList(std::string &out, const std::string &name, TBitmap &bitmap, int columns, bool le, const std::string &grob, const std::string &palette = "") {
+    size_t lengthInBytes = convertBitmap(bitmap, columns, le);
+    
+    if (lengthInBytes == 0 && bitmap.bpp) return false;
+    
+    switch (bitmap.bpp) {
+        case 0:
+            out.append(name).append(":= {");
+            ppl(out, bitmap.bytes.data(), lengthInBytes, columns, le);
+            out.append("};\n");
+            break;
+            
+        case 1:
+        case 4:
+        case 8:
+            out.append(name).append(" := {\n");
+            out.append("  {\n");
+            ppl(out, bitmap.bytes.data(), lengthInBytes, columns, le);
+            out.append("\n  },\n");
+            pplSize(out, bitmap);
+            if (!palette.empty()) {
+                out.append("\n};\n");
+                if (grob != "G0") out.append("\nGROB.Image(").append(grob).append(", CONCAT(").append(name).append(", {").append(palette).append("}));\n");
+                break;
+            }
+            
+            out.append(",\n  {\n");
+            pplPalette(out, bitmap.palette);
+            out.append("\n  }\n};\n");
+            
+            if (grob != "G0") out.append("\nGROB.Image(").append(grob).append(", ").append(name).append(");\n");
+            break;
+        
+            
+        default:
+            out.append(name).append(" := {\n");
+            out.append("  {\n");
+            ppl(out, bitmap.bytes.data(), lengthInBytes, columns, le);
+            out.append("\n  },\n");
+            pplSize(out, bitmap);
+            out.append("\n};\n");
+            if (grob != "G0") out.append("\nGROB.Image(").append(grob).append(", ").append(name).append(");\n");
+            break;
+    }
+    
+    return true;
+}
+
+
+/*
+ Appends the PPL for an animation of equally sized frames. The first frame is
+ listed in full, each later frame only as the 64-bit elements that differ from
+ the frame before it, given as pairs of element index and new value, and a last
+ entry takes the last frame back to the first so that the animation can loop.
+ A frame that changes half or more of its elements is simply listed in full.
+ */
+static bool animationList(std::string &out, const std::string &name, std::vector<TBitmap> &frames, int columns, bool le, const std::string &grob) {
+    if (!grobList(out, name, frames.front(), columns, le, grob)) return false;
+    
+    out.append("\n").append(name).append("_frames := {\n");
+    
+    std::vector<size_t> changes;
+    for (size_t f = 1; f <= frames.size(); ++f) {
+        // The first frame was already converted when it was listed in full.
+        TBitmap &frame = frames[f % frames.size()];
+        int c = columns;
+        size_t length = (f < frames.size() ? convertBitmap(frame, c, le) : listLayout(frame.width, frame.height, frame.bpp, c)) / 8;
+        const uint64_t *previous = (const uint64_t *)frames[f - 1].bytes.data();
+        const uint64_t *current = (const uint64_t *)frame.bytes.data();
+        
+        changes.clear();
+        for (size_t i = 0; i < length; ++i) {
+            if (previous[i] != current[i]) changes.push_back(i);
+        }
+        
+        out.append("  {");
+        if (changes.size() * 2 >= length) {
+            out.append("\n");
+            ppl(out, current, length * 8, c, le);
+            out.append("\n  }");
+        } else {
+            for (size_t i = 0; i < changes.size(); ++i) {
+                if (i) out.append(", ");
+                if (i % c == 0) out.append("\n    ");
+                appendDecimal(out, changes[i] + 1);
+                out.append(", ");
+                pplWord(out, current[changes[i]], le);
+            }
+            out.append(changes.empty() ? "}" : "\n  }");
+        }
+        out.append(f < frames.size() ? ",\n" : "\n");
+    }
+    out.append("};\n\n");
+    
+    /*
+     As a frame that is listed in full holds exactly as many elements as the
+     image data, while a list of changes always holds fewer, the size of the
+     list is enough to tell the two apart.
+     */
+    out
+    .append("// Advances ").append(name).append(" from frame n to frame n + 1, or from the last frame back to the first.\n")
+    .append(name).append("_Frame(n)\n")
+    .append("BEGIN\n")
+    .append("  LOCAL d := ").append(name).append("_frames(n), i;\n")
+    .append("  IF SIZE(d) == SIZE(").append(name).append("(1)) THEN\n")
+    .append("    ").append(name).append("(1) := d;\n")
+    .append("  ELSE\n")
+    .append("    FOR i FROM 1 TO SIZE(d) STEP 2 DO\n")
+    .append("      ").append(name).append("(1, d(i)) := d(i + 1);\n")
+    .append("    END;\n")
+    .append("  END;\n");
+    if (grob != "G0") out.append("  GROB.Image(").append(grob).append(", ").append(name).append(");\n");
+    out.append("END;\n");
+    
+    return true;
+}
+
+/*
+ Appends the PPL list for a tile map, a header of the map's columns and rows and
+ the size of a tile, followed by one entry for each tile, row by row.
+ */
+static void tilemapList(std::string &out, const std::string &name, const TTilemap &tilemap, int width, int height) {
+    out.append(name).append(" := {\n");
+    out.append("  { ");
+    appendDecimal(out, tilemap.columns);
+    out.append(", ");
+    appendDecimal(out, tilemap.rows);
+    out.append(", ");
+    appendDecimal(out, width);
+    out.append(", ");
+    appendDecimal(out, height);
+    out.append(" },\n");
+    out.append("  {");
+    for (size_t i = 0; i < tilemap.map.size(); i += 1) {
+        if (i) out.append(", ");
+        if (i % tilemap.columns == 0) out.append("\n    ");
+        appendDecimal(out, tilemap.map[i]);
+    }
+    out.append("\n  }\n};\n");
+}
+
+/*
+ Appends the PPL list for a font, the size of a cell and the number of glyphs,
+ the bitstream of every glyph packed one after another, and for each glyph its
+ offset in bits into the stream, with its position and size within the cell.
+ 
+ A procedure, name_Glyph(g, x, y, c), draws glyph g, counting from 1, in color c
+ with its cell at x, y on G0, returning the width to advance by.
+ */
+static void fontList(std::string &out, const std::string &name, const TFont &font, int columns) {
+    out.append(name).append(" := {\n");
+    out.append("  { ");
+    appendDecimal(out, font.width);
+    out.append(", ");
+    appendDecimal(out, font.height);
+    out.append(", ");
+    appendDecimal(out, font.glyphs.size());
+    out.append(" },\n");
+    
+    // The bitstream is a sequence of numbers rather than of bytes, so is listed as is whatever the byte order.
+    out.append("  {\n");
+    for (size_t i = 0; i < font.bits.size(); ++i) {
+        if (i) out.append(", ");
+        if (i % columns == 0) out.append(i ? "\n    " : "    ");
+        out.append("#");
+        appendHex(out, font.bits[i], 16);
+        out.append(":64h");
+    }
+    out.append("\n  },\n");
+    
+    out.append("  {");
+    for (size_t i = 0; i < font.glyphs.size(); ++i) {
+        const TGlyph &glyph = font.glyphs[i];
+        out.append(i ? ",\n    { " : "\n    { ");
+        appendDecimal(out, glyph.offset);
+        for (int value : {glyph.x, glyph.y, glyph.width, glyph.height}) {
+            out.append(", ");
+            appendDecimal(out, value);
+        }
+        out.append(" }");
+    }
+    out.append("\n  }\n};\n\n");
+    
+    out
+    .append("// Draws glyph g of ").append(name).append(" in color c with its cell at x, y, returning the width to advance by.\n")
+    .append(name).append("_Glyph(g, x, y, c)\n")
+    .append("BEGIN\n")
+    .append("  LOCAL e := ").append(name).append("(3, g), b := e(1), i, j;\n")
+    .append("  IF e(4) == 0 THEN\n")
+    .append("    RETURN IP(").append(name).append("(1, 1) / 2);\n")
+    .append("  END;\n")
+    .append("  FOR j FROM 0 TO e(5) - 1 DO\n")
+    .append("    FOR i FROM 0 TO e(4) - 1 DO\n")
+    .append("      IF BITAND(BITSR(").append(name).append("(2, IP(b / 64) + 1), b MOD 64), 1) THEN\n")
+    .append("        PIXON_P(G0, x + e(2) + i, y + e(3) + j, c);\n")
+    .append("      END;\n")
+    .append("      b := b + 1;\n")
+    .append("    END;\n")
+    .append("  END;\n")
+    .append("  RETURN e(2) + e(4) + 1;\n")
+    .append("END;\n");
+}
+
+/*
+ Appends the PPL lists for a 32bpp image with its alpha channel split off into a
+ 1bpp mask, name_mask, for use with BLIT_P. An image that is fully opaque needs
+ no mask, and one that is fully transparent needs no image data at all, so there
+ is nothing to load into a graphic object either.
+ */
+static bool alphaList(std::string &out, const std::string &name, TBitmap &bitmap, TBitmap &mask, bool channel, int columns, bool le, bool quantize, const std::string &grob) {
+    switch (splitAlpha(bitmap, mask, channel)) {
+        case AlphaTransparent:
+            if (grob != "G0") {
+                status("❌ ", name, " is fully transparent, there is no image for ", grob, ".\n");
+                return false;
+            }
+            status("👻 ", name, " is fully transparent, no image data generated.\n");
+            out.append(name).append(" := {};\n");
+            return true;
+            
+        case AlphaOpaque:
+            status("🧱 ", name, " is fully opaque, no mask generated.\n");
+            break;
+            
+        case AlphaMasked:
+            break;
+    }
+    
+    if (quantize && quantizeBitmap(bitmap)) {
+        status("🎨 ", name, " quantized to ", (int)bitmap.bpp, "bpp.\n");
+    }
+    
+    if (!grobList(out, name, bitmap, columns, le, grob)) return false;
+    if (!mask.bytes.empty()) {
+        out.append("\n");
+        grobList(out, name + "_mask", mask, columns, le, "G0");
+    }
+    return true;
+}
+
 // MARK: - Command Line
 
 
@@ -140,15 +556,53 @@ void help(void)
     << "Copyright (C) 2024-" << YEAR << " Insoft.\n"
     << "Insoft "<< NAME << " version, " << VERSION_NUMBER << " (BUILD " << BUNDLE_VERSION << ")\n"
     << "\n"
-    << "Usage: " << COMMAND_NAME << " <input-file> [-o <output-file>] [-c <columns>] [-n <name>] [-g<1-9>] [-ppl] \n"
+    << "Usage: " << COMMAND_NAME << " <input-file> [-o <output-file>] [-c <columns>] [-n <name>] [-g<1-9>] [-ppl] [--optimize] [--crop x,y,w,h | --region <name>=x,y,w,h ...]\n"
+    << "       [--manifest <manifest-file> [--shared-palette]] [--alpha [--quantize]]\n"
+    << "       [-MD] [-MF <dep-file>] [-MS] [--frames <frame-file> ...] [--tiles <width>x<height> [--flip]]\n"
+    << "       [--scale <width>x<height> ...] [--variants <hflip,vflip,rot90,rot180,rot270>]\n"
+    << "       [--font <columns>x<rows>]\n"
+    << "       [--dry-run [--budget <bytes>]]\n"
     << "\n"
     << "Options:\n"
-    << "  -o <output-file>           Specify the filename for generated PPL code.\n"
+    << "  -o <output-file>           Specify the filename for generated PPL code, or the directory\n"
+    << "                             for the programs when several input files are given.\n"
     << "  -c <columns>               Number of columns.\n"
     << "  -n <name>                  Custom name.\n"
     << "  -G<1-9>                    Graphic object G1-G9 to use if file is an image.\n"
     << "  --pragma                   Include \"#pragma mode( separator(.,;) integer(h64) )\" line.\n"
     << "  --endian <le|be>           Endianes le(default).\n"
+    << "  --optimize                 Remove unused and duplicate colors and use the smallest bpp.\n"
+    << "  --alpha                    Split the alpha channel of a 32bpp image into a 1bpp mask, an\n"
+    << "                             image without an alpha mask in its header is taken as opaque.\n"
+    << "  --quantize                 Reduce the colors of a 32bpp image split with --alpha to an\n"
+    << "                             indexed image, or to 16bpp if it has over 256 colors.\n"
+    << "  --manifest <manifest-file> Convert every image listed in the manifest into one program, one\n"
+    << "                             per line as: <input-file> [-n <name>] [-G<1-9>] [--bpp <1|4|8>]\n"
+    << "  --shared-palette           Give every indexed image of the manifest one shared palette.\n"
+    << "  -MD                        Write a Make dependency file, and a .opts stamp of the options\n"
+    << "                             used, alongside the output file.\n"
+    << "  -MF <dep-file>             Write a Make dependency file to the given filename.\n"
+    << "  -MS                        Only update the .opts stamp, should the options have changed,\n"
+    << "                             for a build to run before deciding what is out of date.\n"
+    << "  --crop x,y,w,h             Convert only the given region of the image.\n"
+    << "  --region <name>=x,y,w,h    Convert the given region of the image as its own named list,\n"
+    << "                             may be repeated to extract several regions in one pass.\n"
+    << "  --frames                   Treat every input file as a frame of an animation, later frames\n"
+    << "                             are listed only as changes from the frame before, and the last\n"
+    << "                             frame as the changes back to the first. Frames share a palette.\n"
+    << "  --tiles <width>x<height>   List each unique tile once in a tileset image, followed by a\n"
+    << "                             map of which tile is used where.\n"
+    << "  --flip                     Treat tiles that are mirror images of each other as the same.\n"
+    << "  --scale <width>x<height>   Resample the image to the given size, named name_<width>x<height>,\n"
+    << "                             may be repeated to list several sizes from one decode.\n"
+    << "  --variants <variant,...>   Also list the image mirrored or rotated clockwise, named\n"
+    << "                             name_<variant>, any of hflip, vflip, rot90, rot180 and rot270.\n"
+    << "  --font <columns>x<rows>    Slice a 1bpp font sheet into a grid of glyphs, each trimmed to\n"
+    << "                             its ink and packed into one bitstream with a table of glyphs.\n"
+    << "  --dry-run                  Report the projected size of each file, or of every file in a\n"
+    << "                             directory, from its header alone without converting it. Options\n"
+    << "                             that change what is listed can not be combined with it.\n"
+    << "  --budget <bytes>           Flag any file projected to exceed the given .prgm size.\n"
     << "\n"
     << "Additional Commands:\n"
     << "  " << COMMAND_NAME << " {--version | --help}\n"
@@ -202,18 +656,493 @@ fs::path expand_tilde(const fs::path& path) {
     return fs::path(path);
 }
 
+// The name of the list for a file, its stem with the characters PPL does not allow in a name replaced.
+static std::string listName(const fs::path &path) {
+    std::string name = path.stem().string();
+    std::replace(name.begin(), name.end(), '-', '_');
+    std::replace(name.begin(), name.end(), '.', '_');
+    return name;
+}
+
+// MARK: - Manifest
+
+typedef struct {
+    fs::path path;
+    std::string name;
+    std::string grob;
+    int bpp;
+    TBitmap bitmap;
+} TAsset;
+
+/*
+ Splits a line of a manifest into its arguments, which are separated by spaces
+ unless enclosed in double quotes.
+ */
+static std::vector<std::string> splitArguments(const std::string &line) {
+    std::vector<std::string> arguments;
+    std::string argument;
+    bool quoted = false, pending = false;
+    
+    for (char c : line) {
+        if (c == '"') {
+            quoted = !quoted;
+            pending = true;
+            continue;
+        }
+        if (!quoted && isspace((unsigned char)c)) {
+            if (pending) arguments.push_back(argument);
+            argument.clear();
+            pending = false;
+            continue;
+        }
+        argument += c;
+        pending = true;
+    }
+    if (pending) arguments.push_back(argument);
+    
+    return arguments;
+}
+
+/*
+ Reads a manifest, listing one asset to a line as its filename, relative to the
+ manifest, followed by any of -n <name>, -G<1-9> and --bpp <1|4|8>. Blank lines
+ and lines starting with # are ignored.
+ */
+static bool loadManifest(const fs::path &path, std::vector<TAsset> &assets) {
+    std::ifstream is(path);
+    std::string line;
+    int number = 0;
+    
+    if (!is.is_open()) return false;
+    
+    while (std::getline(is, line)) {
+        number++;
+        std::vector<std::string> arguments = splitArguments(line);
+        if (arguments.empty() || arguments.front().starts_with("#")) continue;
+        
+        TAsset asset{};
+        asset.grob = "G0";
+        asset.path = expand_tilde(fs::path(arguments.front()));
+        if (asset.path.is_relative()) asset.path = path.parent_path() / asset.path;
+        
+        for (size_t i = 1; i < arguments.size(); i++) {
+            if (arguments[i] == "-n" && i + 1 < arguments.size()) {
+                asset.name = arguments[++i];
+                continue;
+            }
+            if (arguments[i].starts_with("-G")) {
+                asset.grob = arguments[i].substr(1);
+                continue;
+            }
+            if (arguments[i] == "--bpp" && i + 1 < arguments.size()) {
+                asset.bpp = atoi(arguments[++i].c_str());
+                continue;
+            }
+            status("❌ ", path.filename(), ":", number, " unknown option '", arguments[i], "'.\n");
+            return false;
+        }
+        
+        if (asset.name.empty()) {
+            asset.name = listName(asset.path);
+        }
+        assets.push_back(asset);
+    }
+    
+    return true;
+}
+
+/*
+ Converts every asset of a manifest into a single program. With a shared palette,
+ every indexed image is remapped to one palette of all the colors they use, which
+ is listed once as name_palette instead of with each image.
+ */
+static bool buildManifest(std::vector<TAsset> &assets, const std::string &name, int columns, bool le, bool optimize, bool shared, std::string &utf8) {
+    parallel::forRange(assets.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            TBitmap &bitmap = assets[i].bitmap;
+            bitmap = loadBitmapImage(assets[i].path.string());
+            if (bitmap.bytes.empty()) {
+                if (isBitmapFile(assets[i].path.string())) continue;
+                loadBinaryFile(assets[i].path.string().c_str(), bitmap);
+            } else {
+                monochromePalette(bitmap);
+            }
+        }
+    });
+    
+    std::vector<TBitmap *> indexed;
+    for (auto &asset : assets) {
+        if (asset.bitmap.bytes.empty()) {
+            status("❌ Unable to load ", asset.path.filename(), ".\n");
+            return false;
+        }
+        if (asset.bitmap.bpp >= 1 && asset.bitmap.bpp <= 8) indexed.push_back(&asset.bitmap);
+        if (optimize && !shared) optimizePalette(asset.bitmap);
+    }
+    
+    std::string palette;
+    if (shared && !indexed.empty()) {
+        if (!sharePalette(indexed)) {
+            status("❌ Images use more than 256 colors between them, unable to share a palette.\n");
+            return false;
+        }
+        palette = name + "_palette";
+        status("🎨 ", indexed.size(), " image(s) share a palette of ", indexed.front()->palette.size(), " color(s).\n");
+        
+        utf8.append(palette).append(" := {\n");
+        pplPalette(utf8, indexed.front()->palette);
+        utf8.append("\n};\n\n");
+    }
+    
+    for (auto &asset : assets) {
+        if (asset.bpp && !repackBitmap(asset.bitmap, asset.bpp)) {
+            status("❌ ", asset.name, " can not be converted to ", asset.bpp, "bpp.\n");
+            return false;
+        }
+        
+        bool indexed = asset.bitmap.bpp >= 1 && asset.bitmap.bpp <= 8;
+        if (&asset != &assets.front()) utf8.append("\n");
+        if (!grobList(utf8, asset.name, asset.bitmap, columns, le, asset.grob, indexed ? palette : "")) {
+            status("❌ ", asset.name, " has an unsupported bpp.\n");
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+// MARK: - Dry Run
+
+typedef struct {
+    fs::path path;
+    size_t elements;
+    size_t bytes;
+    int bpp;
+} TProjection;
+
+/*
+ Returns the number of characters that ppl() generates for a list of the given
+ number of 64-bit elements, without the need to generate the list.
+ */
+static size_t pplLength(size_t elements, int columns) {
+    if (elements == 0) return 0;
+    size_t lines = (elements + columns - 1) / columns;
+    return elements * 21 + (elements - 1) * 2 + 4 + (lines - 1) * 5;
+}
+
+static TProjection project(const fs::path &path, int columns, size_t prefix, const std::string &grob) {
+    TProjection projection{path, 0, 0, 0};
+    std::string name = listName(path);
+    
+    TBitmapHeader header = loadBitmapHeader(path.string());
+    size_t lengthInBytes = 0;
+    size_t colors = header.colors;
+    
+    if (header.bpp == 0) {
+        // A file that claims to be a bitmap but is not valid can not be converted.
+        if (isBitmapFile(path.string())) return projection;
+        
+        // Nor can a file that is missing or unreadable.
+        std::error_code ec;
+        lengthInBytes = fs::file_size(path, ec);
+        if (ec) return projection;
+        if (columns < 1) columns = 1;
+    } else {
+        lengthInBytes = listLayout(header.width, header.height, header.bpp, columns);
+        if (lengthInBytes == 0) {
+            projection.bpp = header.bpp;
+            return projection;
+        }
+        if (header.bpp == 1) colors = 2;
+    }
+    
+    projection.bpp = header.bpp;
+    projection.elements = lengthInBytes / 8;
+    
+    /*
+     The length of the generated PPL code is worked out from the same layout
+     main() uses to write it out.
+     */
+    size_t length = prefix + name.length() + pplLength(projection.elements, columns);
+    if (header.bpp == 0) {
+        length += 7;
+    } else {
+        length += 24 + std::to_string(header.width).length() + std::to_string(header.height).length() + std::to_string(header.bpp).length();
+        if (header.bpp <= 8) {
+            length += 20;
+            if (colors) length += colors * 11 + (colors - 1) * 2 + (colors - 1) / 16 * 5;
+        } else {
+            length += 6;
+        }
+        if (grob != "G0") length += 17 + grob.length() + name.length();
+    }
+    
+    // UTF-16LE with a BOM.
+    projection.bytes = 2 + length * 2;
+    return projection;
+}
+
+static int dryRun(const std::vector<fs::path> &paths, int columns, size_t prefix, const std::string &grob, size_t budget) {
+    std::vector<fs::path> files;
+    
+    for (const auto &path : paths) {
+        if (!fs::is_directory(path)) {
+            files.push_back(path);
+            continue;
+        }
+        
+        /*
+         A directory that can not be read is reported and skipped, rather than
+         ending the walk, by trying to open each one before descending into it.
+         */
+        size_t first = files.size();
+        std::error_code ec;
+        fs::recursive_directory_iterator it(path, ec), end;
+        for (; !ec && it != end; it.increment(ec)) {
+            const fs::directory_entry &entry = *it;
+            if (entry.is_directory(ec)) {
+                if (!ec) fs::directory_iterator(entry.path(), ec);
+                if (ec) {
+                    status("❌ Skipped ", entry.path(), ", ", ec.message(), ".\n");
+                    it.disable_recursion_pending();
+                    ec.clear();
+                }
+                continue;
+            }
+            if (!entry.is_regular_file(ec)) {
+                ec.clear();
+                continue;
+            }
+            if (entry.path().filename().string().starts_with(".")) continue;
+            if (entry.path().extension() == ".prgm") continue;
+            files.push_back(entry.path());
+        }
+        if (ec) status("❌ Skipped the rest of ", path, ", ", ec.message(), ".\n");
+        std::sort(files.begin() + first, files.end());
+    }
+    
+    std::vector<TProjection> projections(files.size());
+    parallel::forRange(files.size(), 32, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            projections[i] = project(files[i], columns, prefix, grob);
+    });
+    
+    size_t violations = 0, total = 0;
+    std::cout << std::setw(10) << "elements" << std::setw(12) << "bytes" << std::setw(5) << "bpp" << "  file\n";
+    for (const auto &projection : projections) {
+        std::cout << std::dec << std::setfill(' ')
+        << std::setw(10) << projection.elements
+        << std::setw(12) << projection.bytes
+        << std::setw(5) << projection.bpp
+        << "  " << projection.path.string();
+        
+        bool violation = true;
+        if (projection.bytes == 0) {
+            std::cout << (fs::exists(projection.path) ? "  ❌ invalid bitmap" : "  ❌ not found");
+        } else if (projection.elements > 10000) {
+            std::cout << "  ❌ exceeds 10,000 elements";
+        } else if (budget && projection.bytes > budget) {
+            std::cout << "  ❌ exceeds " << budget << " bytes";
+        } else {
+            violation = false;
+        }
+        std::cout << "\n";
+        
+        if (violation) violations++;
+        total += projection.bytes;
+    }
+    std::cout << projections.size() << " file(s), " << total << " bytes projected, " << violations << " violation(s).\n";
+    
+    return violations ? 1 : 0;
+}
+
+// MARK: - Dependencies
+
+static std::string makeEscape(const std::string &path) {
+    std::string escaped;
+    for (char c : path) {
+        if (c == ' ' || c == '#' || c == '\\') escaped += '\\';
+        if (c == '$') escaped += '$';
+        escaped += c;
+    }
+    return escaped;
+}
+
+/*
+ Returns a fingerprint of every option given, other than those controlling the
+ dependency file itself, along with the version of this tool, as a change to
+ either could change the output. The input files given as arguments, at the
+ positions listed, are left out in favour of the inputs of the one output, so
+ that adding or removing an image of a batch leaves the other images as they are.
+ */
+static std::string optionsFingerprint(int argc, const char * argv[], const std::vector<int> &positional, const std::vector<fs::path> &inputs) {
+    // FNV-1a
+    uint64_t hash = 0xCBF29CE484222325;
+    std::string options = VERSION_NUMBER;
+    
+    for (int n = 1; n < argc; n++) {
+        if (std::find(positional.begin(), positional.end(), n) != positional.end()) continue;
+        if (strcmp(argv[n], "-MD") == 0 || strcmp(argv[n], "-MS") == 0) continue;
+        if (strcmp(argv[n], "-MF") == 0) {
+            n++;
+            continue;
+        }
+        options.append("\n").append(argv[n]);
+    }
+    for (const auto &path : inputs) {
+        options.append("\n").append(path.string());
+    }
+    for (unsigned char c : options) {
+        hash ^= c;
+        hash *= 0x100000001B3;
+    }
+    
+    std::ostringstream os;
+    os << std::hex << std::setfill('0') << std::setw(16) << hash;
+    return os.str();
+}
+
+// The stamp file of the options, kept beside the dependency file.
+static fs::path stampPath(const fs::path &depfile) {
+    fs::path stamp = depfile;
+    stamp.replace_extension(".opts");
+    return stamp;
+}
+
+/*
+ Writes the fingerprint of the options to a stamp file, leaving the file untouched
+ should it already hold the same fingerprint, so that it only becomes newer when
+ the options have changed. Returns false if the file could not be written.
+ */
+static bool writeStamp(const fs::path &stamp, const std::string &fingerprint) {
+    std::ifstream is(stamp);
+    std::string previous;
+    if (is.is_open() && std::getline(is, previous) && previous == fingerprint) return true;
+    is.close();
+    
+    std::ofstream os(stamp);
+    if (!os.is_open()) return false;
+    os << fingerprint << "\n";
+    return true;
+}
+
+/*
+ Writes a Make compatible dependency file for the output, with the stamp file of
+ the options as one of its prerequisites. The stamp is brought up to date and
+ given the time of the output, as the output now reflects the options, so only a
+ later change to the options, written to the stamp with -MS, makes it stale.
+ */
+static bool writeDepfile(const fs::path &depfile, const fs::path &outpath, std::vector<fs::path> dependencies, const std::string &fingerprint) {
+    fs::path stamp = stampPath(depfile);
+    std::error_code ec;
+    if (!writeStamp(stamp, fingerprint)) return false;
+    if (fs::exists(outpath, ec)) fs::last_write_time(stamp, fs::last_write_time(outpath, ec), ec);
+    dependencies.push_back(stamp);
+    
+    std::ofstream os(depfile);
+    if (!os.is_open()) return false;
+    
+    os << makeEscape(outpath.string()) << ":";
+    for (const auto &path : dependencies) {
+        os << " \\\n  " << makeEscape(path.string());
+    }
+    os << "\n";
+    
+    // Empty rules, so that a deleted input does not stop Make.
+    for (const auto &path : dependencies) {
+        os << "\n" << makeEscape(path.string()) << ":\n";
+    }
+    
+    return true;
+}
+
 // MARK: - Main
 
+typedef struct {
+    std::string name;
+    int x, y, width, height;
+} TRegion;
+
+typedef struct {
+    int width, height;
+} TScale;
+
+typedef struct {
+    const char *name;
+    Orientation orientation;
+} TVariant;
+
+static const TVariant orientations[] = {
+    {"hflip", OrientationHFlip},
+    {"vflip", OrientationVFlip},
+    {"rot90", OrientationRot90},
+    {"rot180", OrientationRot180},
+    {"rot270", OrientationRot270}
+};
+
+static bool parseRegion(const std::string &text, TRegion &region) {
+    return sscanf(text.c_str(), "%d,%d,%d,%d", &region.x, &region.y, &region.width, &region.height) == 4 && region.width > 0 && region.height > 0;
+}
+
+/*
+ Everything a conversion allocates is owned by the context, and as the context is
+ reused from one image to the next, its buffers grow to fit the largest image and
+ are then simply reused, instead of being allocated afresh for every image.
+ */
+typedef struct {
+    TBitmap bitmap;
+    TBitmap mask;
+    bool alpha;         // Whether the image being converted has an alpha channel.
+    std::string text;
+    std::string buffer;
+} TContext;
+
+// A converted program, encoded and waiting to be saved.
+typedef struct {
+    fs::path inpath;
+    fs::path outpath;
+    std::string buffer;
+} TProgram;
+
+// Saves the text of a context as UTF-16LE, encoded into the reused buffer of the context.
+static bool saveProgram(const fs::path &outpath, TContext &context) {
+    if (outpath == "/dev/stdout") {
+        std::cout << context.text;
+        return true;
+    }
+    utf::encode(context.text, context.buffer);
+    return utf::save(outpath, context.buffer);
+}
+
 int main(int argc, const char * argv[]) {
     std::string prefix, sufix, name;
     fs::path inpath, outpath;
+    std::vector<fs::path> inpaths;
+    std::vector<int> positional;
     
     int columns = 8;
     std::string grob("G0");
     bool le = true;
+    bool optimize = false;
+    bool dryrun = false;
+    bool animate = false;
+    int tileWidth = 0, tileHeight = 0;
+    int fontColumns = 0, fontRows = 0;
+    bool depend = false;
+    bool stampOnly = false;
+    fs::path depfile;
+    bool flips = false;
+    bool alpha = false;
+    bool quantize = false;
+    fs::path manifest;
+    bool shared = false;
+    size_t budget = 0;
     
-    std::string utf8;
-    std::ostringstream os;
+    std::string pragma;
+    std::vector<TRegion> regions;
+    std::vector<TScale> scales;
+    std::vector<TVariant> variants;
+    std::vector<fs::path> dependencies;
 
     if ( argc == 1 )
     {
@@ -246,7 +1175,7 @@ int main(int argc, const char * argv[]) {
         }
         
         if (args == "--pragma") {
-            utf8.append("#pragma mode( separator(.,;) integer(h64) )\n\n");
+            pragma = "#pragma mode( separator(.,;) integer(h64) )\n\n";
             continue;
         }
         
@@ -263,6 +1192,152 @@ int main(int argc, const char * argv[]) {
             continue;
         }
         
+        if (args == "--dry-run") {
+            dryrun = true;
+            continue;
+        }
+        
+        if (args == "--budget") {
+            if ( n + 1 >= argc ) {
+                error();
+                exit(100);
+            }
+            budget = strtoull(argv[++n], nullptr, 10);
+            continue;
+        }
+        
+        if (args == "--crop") {
+            TRegion region{};
+            if ( n + 1 >= argc || !parseRegion(argv[++n], region) ) {
+                error();
+                exit(100);
+            }
+            // Every region without a name is listed under the same name, so only one is allowed.
+            if (std::any_of(regions.begin(), regions.end(), [](const TRegion &region) { return region.name.empty(); })) {
+                status("❌ Only one --crop can be given, use --region to name each of several regions.\n");
+                exit(100);
+            }
+            regions.push_back(region);
+            continue;
+        }
+        
+        if (args == "--region") {
+            TRegion region{};
+            std::string value = n + 1 < argc ? argv[++n] : "";
+            size_t pos = value.find('=');
+            if (pos == std::string::npos || pos == 0 || !parseRegion(value.substr(pos + 1), region)) {
+                error();
+                exit(100);
+            }
+            region.name = value.substr(0, pos);
+            regions.push_back(region);
+            continue;
+        }
+        
+        if (args == "--manifest") {
+            if ( n + 1 >= argc ) {
+                error();
+                exit(100);
+            }
+            manifest = expand_tilde(fs::path(argv[++n]));
+            continue;
+        }
+        
+        if (args == "--shared-palette") {
+            shared = true;
+            continue;
+        }
+        
+        if (args == "-MD") {
+            depend = true;
+            continue;
+        }
+        
+        if (args == "-MS") {
+            depend = true;
+            stampOnly = true;
+            continue;
+        }
+        
+        if (args == "-MF") {
+            if ( n + 1 >= argc ) {
+                error();
+                exit(100);
+            }
+            depend = true;
+            depfile = expand_tilde(fs::path(argv[++n]));
+            continue;
+        }
+        
+        if (args == "--tiles") {
+            if ( n + 1 >= argc || sscanf(argv[++n], "%dx%d", &tileWidth, &tileHeight) != 2 || tileWidth < 1 || tileHeight < 1 ) {
+                error();
+                exit(100);
+            }
+            continue;
+        }
+        
+        if (args == "--scale") {
+            TScale scale{};
+            if ( n + 1 >= argc || sscanf(argv[++n], "%dx%d", &scale.width, &scale.height) != 2 || scale.width < 1 || scale.height < 1 ) {
+                error();
+                exit(100);
+            }
+            scales.push_back(scale);
+            continue;
+        }
+        
+        if (args == "--variants") {
+            std::string value = n + 1 < argc ? argv[++n] : "";
+            std::stringstream list(value);
+            for (std::string variant; std::getline(list, variant, ',');) {
+                auto it = std::find_if(std::begin(orientations), std::end(orientations), [&](const auto &orientation) { return variant == orientation.name; });
+                if (it == std::end(orientations)) {
+                    error();
+                    exit(100);
+                }
+                variants.push_back(*it);
+            }
+            if (variants.empty()) {
+                error();
+                exit(100);
+            }
+            continue;
+        }
+        
+        if (args == "--font") {
+            if ( n + 1 >= argc || sscanf(argv[++n], "%dx%d", &fontColumns, &fontRows) != 2 || fontColumns < 1 || fontRows < 1 ) {
+                error();
+                exit(100);
+            }
+            continue;
+        }
+        
+        if (args == "--flip") {
+            flips = true;
+            continue;
+        }
+        
+        if (args == "--alpha") {
+            alpha = true;
+            continue;
+        }
+        
+        if (args == "--quantize") {
+            quantize = true;
+            continue;
+        }
+        
+        if (args == "--frames") {
+            animate = true;
+            continue;
+        }
+        
+        if (args == "--optimize") {
+            optimize = true;
+            continue;
+        }
+        
         if (args.substr(0,2) == "-G") {
             grob = args.substr(1);
             continue;
@@ -294,18 +1369,245 @@ int main(int argc, const char * argv[]) {
         }
         
         
+        inpaths.push_back(expand_tilde(fs::path(argv[n])));
+        positional.push_back(n);
         if (inpath.empty()) {
-            inpath = fs::path(argv[n]);
-            inpath = expand_tilde(inpath);
+            inpath = inpaths.front();
         }
     }
+    // The dry run projects each image as it is, so any option that changes what is listed is refused.
+    if (dryrun && (optimize || alpha || animate || tileWidth || fontColumns || !manifest.empty() || !regions.empty() || !scales.empty() || !variants.empty())) {
+        status("❌ --dry-run can not be combined with --optimize, --alpha, --frames, --tiles, --font, --manifest,\n"
+               "   --region, --crop, --scale or --variants.\n");
+        exit(100);
+    }
+    
     if (outpath != "/dev/stdout") info();
     
-    if (!fs::exists(inpath)) {
-        std::cerr << "❓File '" << inpath << "' not found.\n";
+    // The output and the names used are taken from the manifest rather than an image.
+    if (!manifest.empty()) {
+        inpath = manifest;
+    }
+    
+    // Several images are each checked in turn as they are converted, so one missing does not stop the rest.
+    bool batch = inpaths.size() > 1 && !animate && manifest.empty() && !dryrun;
+    
+    // A dry run lists every input, one missing is simply projected as invalid.
+    if (!batch && !dryrun && !fs::exists(inpath)) {
+        status("❓File '", inpath, "' not found.\n");
         return 0;
     }
     
+    if (dryrun) {
+        return dryRun(inpaths, columns < 1 ? 1 : columns, pragma.length(), grob, budget);
+    }
+    
+    if (regions.empty()) regions.push_back({"", 0, 0, 0, 0});
+    
+    // Appends the lists of a single decoded image to the text of the context.
+    auto emit = [&](TContext &context, TBitmap &bitmap, const std::string &label, const std::string &grob) -> bool {
+        if (fontColumns) {
+            TFont font = buildFont(bitmap, fontColumns, fontRows);
+            if (font.glyphs.empty()) {
+                status("❌ ", label, " is not a 1bpp font sheet of ", fontColumns, "x", fontRows, " glyphs of up to 255x255.\n");
+                return false;
+            }
+            status("🔤 ", font.glyphs.size(), " glyph(s) of ", label, " packed into ", font.bits.size() * 8, " bytes.\n");
+            fontList(context.text, label, font, columns < 1 ? 8 : columns);
+            return true;
+        }
+        
+        if (alpha && bitmap.bpp == 32) {
+            return alphaList(context.text, label, bitmap, context.mask, context.alpha, columns, le, quantize, grob);
+        }
+        
+        if (tileWidth && bitmap.bpp) {
+            TTilemap tilemap = buildTilemap(bitmap, tileWidth, tileHeight, flips);
+            if (tilemap.tileset.bytes.empty()) {
+                status("❌ Too many unique tiles in ", label, ", at most ", TILE_INDEX + 1, " that fit in a single image can be listed.\n");
+                return false;
+            }
+            status("🧩 ", tilemap.map.size(), " tile(s) of ", label, " reduced to ", tilemap.tileset.height / tileHeight, " unique tile(s).\n");
+            if (!grobList(context.text, label, tilemap.tileset, columns, le, grob)) return false;
+            context.text.append("\n");
+            tilemapList(context.text, label + "_map", tilemap, tileWidth, tileHeight);
+            return true;
+        }
+        
+        return grobList(context.text, label, bitmap, columns, le, grob);
+    };
+    
+    /*
+     Appends the lists of an image followed by each of its variants. The variants are
+     made before the image itself is listed, as listing converts its pixels in place.
+     */
+    auto emitVariants = [&](TContext &context, TBitmap &bitmap, const std::string &label, const std::string &grob) -> bool {
+        std::vector<TBitmap> oriented;
+        for (const TVariant &variant : variants) {
+            oriented.push_back(orientBitmap(bitmap, variant.orientation));
+            if (oriented.back().bytes.empty()) {
+                status("❌ ", label, " has an unsupported bpp for variants.\n");
+                return false;
+            }
+        }
+        
+        if (!emit(context, bitmap, label, grob)) return false;
+        for (size_t i = 0; i < oriented.size(); ++i) {
+            context.text.append("\n");
+            if (!emit(context, oriented[i], label + "_" + variants[i].name, "G0")) return false;
+        }
+        return true;
+    };
+    
+    /*
+     Converts each region of an image, or the whole image, at each of the sizes
+     given, appending the lists to the text of the context. A graphic object can
+     only hold one image, so -G only applies to a single image.
+     */
+    auto convert = [&](TContext &context, const fs::path &inpath, const std::string &name) -> bool {
+        TBitmap &bitmap = context.bitmap;
+        const std::string &single = regions.size() == 1 && scales.size() < 2 ? grob : "G0";
+        
+        // Only the header tells whether the fourth byte of a 32bpp pixel is alpha at all.
+        context.alpha = alpha && loadBitmapHeader(inpath.string()).alpha;
+        
+        for (const auto &region : regions) {
+            const std::string &label = region.name.empty() ? name : region.name;
+            
+            if (region.width) {
+                if (!loadBitmapImage(inpath.string(), region.x, region.y, region.width, region.height, bitmap)) {
+                    status("❌ Region ", label, " is not within the image.\n");
+                    return false;
+                }
+            } else {
+                loadBitmapImage(inpath.string(), bitmap);
+            }
+            
+            if (bitmap.bytes.empty()) {
+                if (isBitmapFile(inpath.string())) {
+                    status("❌ File ", inpath.filename(), " is not a valid bitmap image.\n");
+                    return false;
+                }
+                bitmap.palette.clear();
+                loadBinaryFile(inpath.string().c_str(), bitmap);
+            } else {
+                monochromePalette(bitmap);
+                
+                /*
+                 The palette is analysed before the per-bpp conversion, as optimizing
+                 may reduce the bpp of the image and so change the conversion applied.
+                 */
+                if (optimize && !fontColumns && optimizePalette(bitmap)) {
+                    status("🎨 Palette of ", label, " reduced to ", bitmap.palette.size(), " color(s) at ", (int)bitmap.bpp, "bpp.\n");
+                }
+            }
+            
+            if (&region != &regions.front()) context.text.append("\n");
+            
+            if (scales.empty()) {
+                if (!emitVariants(context, bitmap, label, single)) return false;
+                continue;
+            }
+            
+            // The image is decoded once, and each size resampled from it in turn.
+            for (const auto &scale : scales) {
+                TBitmap scaled = scaleBitmap(bitmap, scale.width, scale.height);
+                if (scaled.bytes.empty()) {
+                    status("❌ ", label, " can not be scaled to ", scale.width, "x", scale.height, ".\n");
+                    return false;
+                }
+                if (&scale != &scales.front()) context.text.append("\n");
+                if (!emitVariants(context, scaled, label + "_" + std::to_string(scale.width) + "x" + std::to_string(scale.height), single)) return false;
+            }
+        }
+        return true;
+    };
+    
+    TContext context{};
+    
+    /*
+     Several images, when not the frames of an animation, are each converted to a
+     program of their own, named after the image and placed beside it, or in the
+     directory given with -o.
+     
+     The images are converted as a pipeline. Each worker thread has a context of its
+     own and reads and converts the next image as soon as it is free, so reading one
+     image overlaps converting others, while a single writer thread saves finished
+     programs. The queue of programs waiting to be saved is bounded, so at most one
+     output buffer per worker, plus the depth of the queue, is ever held in memory,
+     and buffers the writer is done with are handed back to be reused.
+     */
+    if (batch) {
+        if (!outpath.empty() && !fs::is_directory(outpath)) {
+            status("❌ The output for several images must be a directory.\n");
+            return -1;
+        }
+        
+        if (stampOnly) {
+            for (const auto &path : inpaths) {
+                fs::path dep = (outpath.empty() ? path.parent_path() : outpath) / (path.stem().string() + ".d");
+                if (!writeStamp(stampPath(dep), optionsFingerprint(argc, argv, positional, {path}))) return -1;
+            }
+            return 0;
+        }
+        
+        size_t threads = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), inpaths.size());
+        std::vector<TContext> contexts(threads);
+        parallel::Queue<TProgram> programs(threads);
+        parallel::Queue<std::string> buffers(threads * 2 + 1);
+        std::atomic<bool> failed{false};
+        
+        std::thread writer([&] {
+            TProgram program;
+            while (programs.pop(program)) {
+                if (!utf::save(program.outpath, program.buffer)) {
+                    status("❌ Unable to create file ", program.outpath.filename(), ".\n");
+                    failed = true;
+                } else {
+                    status("✅ File ", program.outpath.filename(), " succefuly created.\n");
+                }
+                
+                if (depend) {
+                    fs::path dep = program.outpath;
+                    dep.replace_extension(".d");
+                    if (!writeDepfile(dep, program.outpath, {program.inpath}, optionsFingerprint(argc, argv, positional, {program.inpath}))) {
+                        status("❌ Unable to create dependency file ", dep.filename(), ".\n");
+                    }
+                }
+                buffers.push(std::move(program.buffer));
+            }
+        });
+        
+        parallel::forEach(inpaths.size(), threads, [&](size_t index, size_t worker) {
+            const fs::path &path = inpaths[index];
+            TContext &context = contexts[worker];
+            
+            if (!fs::exists(path)) {
+                status("❓File '", path, "' not found.\n");
+                failed = true;
+                return true;
+            }
+            
+            context.text.assign(pragma);
+            if (!convert(context, path, listName(path))) {
+                failed = true;
+                return false;
+            }
+            
+            TProgram program;
+            program.inpath = path;
+            program.outpath = (outpath.empty() ? path.parent_path() : outpath) / (path.stem().string() + ".prgm");
+            buffers.tryPop(program.buffer);
+            utf::encode(context.text, program.buffer);
+            programs.push(std::move(program));
+            return true;
+        });
+        
+        programs.close();
+        writer.join();
+        return failed ? -1 : 0;
+    }
+    
     if (outpath.empty()) {
         outpath = inpath.parent_path() / (inpath.stem().string() + ".prgm");
     }
@@ -320,131 +1622,65 @@ int main(int argc, const char * argv[]) {
     }
     
     if (name.empty()) {
-        name = inpath.stem().string();
-        name = regex_replace(name, std::regex(R"([-.])"), "_");
+        name = listName(inpath);
     }
     
-    size_t lengthInBytes = 0;
-    TBitmap bitmap{};
-    bitmap = loadBitmapImage(inpath.string());
-    if (bitmap.bytes.empty()) {
-        lengthInBytes = loadBinaryFile(inpath.string().c_str(), bitmap);
-    } else {
-        switch (bitmap.bpp) {
-            case 1:
-                lengthInBytes = bitmap.width * bitmap.height / 8;
-                columns = bitmap.width / 64;
-                bitmap.palette.resize(0);
-                bitmap.palette.push_back(0xFFFFFFFF);
-                bitmap.palette.push_back(0xFF);
-                if (!bitmap.bytes.empty()) {
-                    uint8_t *bytes = (uint8_t *)bitmap.bytes.data();
-                    for (int i = 0; i < lengthInBytes; i += 1) {
-                        uint8_t result = 0;
-                        for (int n = 0; n < 8; n += 1) {
-                            result <<= 1;
-                            result |= bytes[i] & 1;
-                            bytes[i] >>= 1;
-                        }
-                        bytes[i] = result;
-                    }
-                }
-                break;
-                
-            case 4:
-                lengthInBytes = bitmap.width * bitmap.height / 2;
-                columns = bitmap.width / 16;
-                if (!bitmap.bytes.empty() && le) {
-                    /*
-                     Due to the use of little-endian format, when the 8-byte sequence
-                     is interpreted as a single 64-bit number, the bytes are stored in
-                     reverse order (from least significant to most significant).
-                     Since this data represents an image where each nibble corresponds
-                     to an index, we must first swap the nibbles in the entire data
-                     sequence to ensure they remain in the correct order when read from
-                     right to left.
-                     */
-                    
-                    uint8_t *bytes = (uint8_t *)bitmap.bytes.data();
-                    for (int i = 0; i < lengthInBytes; i += 1) {
-                        // Swap nibbles
-                        bytes[i] = bytes[i] >> 4 | bytes[i] << 4;
-                    }
-                }
-                break;
-                
-            case 8:
-                lengthInBytes = bitmap.width * bitmap.height;
-                columns = bitmap.width / 8;
-                break;
-                
-            case 16:
-                lengthInBytes = bitmap.width * bitmap.height * 2;
-                break;
-                
-            case 32:
-                lengthInBytes = bitmap.width * bitmap.height * 4;
-                break;
-                
-            default:
-                return -1;
-                break;
-        }
+    if (depend && depfile.empty() && outpath != "/dev/stdout") {
+        depfile = outpath;
+        depfile.replace_extension(".d");
     }
-
-    if (columns < 1) columns = 1;
     
-
-    switch (bitmap.bpp) {
-        case 0:
-            utf8 += name + ":= {" + ppl(bitmap.bytes.data(), lengthInBytes, columns, le) + "};\n";
-            break;
-            
-        case 1:
-        case 4:
-        case 8:
-            os << name << " := {\n";
-            os << "  {\n" << ppl(bitmap.bytes.data(), lengthInBytes, columns, le) << "\n  },\n";
-            os << "  { " << std::dec << bitmap.width << ", " << bitmap.height << ", " << bitmap.bpp << " },\n";
-            
-            os << "  {\n    ";
-            for (int i = 0; i < bitmap.palette.size(); i += 1) {
-                uint32_t color = bitmap.palette.at(i);
-#ifdef __LITTLE_ENDIAN__
-                color = swap_endian(color);
-#endif
-                color &= 0xFFFFFF;
-                if (i) os << ", ";
-                if (i % 16 == 0 && i) os << "\n    ";
-                os << "#" << std::uppercase << std::hex << std::setfill('0') << std::setw(6) << color << ":32h";
+    // Only the stamp of the options is brought up to date, for a build to tell whether they have changed.
+    if (stampOnly) {
+        return !depfile.empty() && writeStamp(stampPath(depfile), optionsFingerprint(argc, argv, positional, inpaths)) ? 0 : -1;
+    }
+    
+    context.text.assign(pragma);
+    
+    if (!manifest.empty()) {
+        std::vector<TAsset> assets;
+        if (!loadManifest(manifest, assets) || !buildManifest(assets, name, columns, le, optimize, shared, context.text)) {
+            return -1;
+        }
+        dependencies.push_back(manifest);
+        for (const auto &asset : assets) dependencies.push_back(asset.path);
+    } else if (animate) {
+        dependencies = inpaths;
+        std::vector<TBitmap> frames;
+        for (const auto &path : inpaths) {
+            frames.push_back(loadBitmapImage(path.string()));
+            TBitmap &frame = frames.back();
+            if (frame.bytes.empty() || frame.width != frames.front().width || frame.height != frames.front().height || frame.bpp != frames.front().bpp) {
+                status("❌ Frame ", path.filename(), " is not a bitmap image of the same size and bpp as the first frame.\n");
+                return -1;
             }
-            os << "\n  }\n};\n";
             
-            if (grob != "G0") os << "\nGROB.Image(" << grob << ", " << name << ");\n";
-            utf8.append(os.str());
-            break;
+            // Only the first frame's palette is listed, every frame has to share it.
+            monochromePalette(frame);
+            if (frame.palette != frames.front().palette) {
+                status("❌ Frame ", path.filename(), " does not have the same palette as the first frame.\n");
+                return -1;
+            }
+        }
         
-            
-        default:
-            os << name << " := {\n";
-            os << "  {\n" << ppl(bitmap.bytes.data(), lengthInBytes, columns, le) << "\n  },\n";
-            os << "  { " << std::dec << bitmap.width << ", " << bitmap.height << ", " << bitmap.bpp << " };\n}\n";
-            if (grob != "G0") os << "\nGROB.Image(" << grob << ", " << name << ");\n";
-            utf8.append(os.str());
-            break;
-    }
-    
-
-    if (outpath == "/dev/stdout") {
-        std::cout << utf8;
+        if (!animationList(context.text, name, frames, columns, le, grob)) return -1;
     } else {
-        std::wstring utf16 = utf::utf16(utf8);
-        utf::save(outpath, utf16);
+        dependencies.push_back(inpath);
+        if (!convert(context, inpath, name)) return -1;
     }
+    
+    saveProgram(outpath, context);
     if (fs::exists(outpath)) {
-        std::cerr << "✅ File " << outpath.filename() << " succefuly created.\n";
+        status("✅ File ", outpath.filename(), " succefuly created.\n");
     } else {
-        std::cerr << "❌ Unable to create file " << outpath.filename() << ".\n";
+        status("❌ Unable to create file ", outpath.filename(), ".\n");
+        return 0;
+    }
+    
+    if (depend) {
+        if (!depfile.empty() && !writeDepfile(depfile, outpath, dependencies, optionsFingerprint(argc, argv, positional, inpaths))) {
+            status("❌ Unable to create dependency file ", depfile.filename(), ".\n");
+        }
     }
     
     return 0;
@@ -0,0 +1,211 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include "orient.hpp"
+
+#include <algorithm>
+
+// Large enough to make good use of each cache line read, small enough for a block of both images to stay in cache.
+#define BLOCK 32
+
+static bool isSupported(const TBitmap &bitmap)
+{
+    switch (bitmap.bpp) {
+        case 1: case 4: case 8: case 16: case 32:
+            return true;
+            
+        default:
+            return false;
+    }
+}
+
+static void flipVertically(TBitmap &bitmap)
+{
+    size_t stride = bitmapStride(bitmap);
+    uint8_t *bytes = bitmap.bytes.data();
+    
+    for (size_t top = 0, bottom = bitmap.height - 1; top < bottom; ++top, --bottom)
+        std::swap_ranges(bytes + top * stride, bytes + (top + 1) * stride, bytes + bottom * stride);
+}
+
+/*
+ For 8bpp and above the pixels of each row are simply reversed. Packed 1bpp and 4bpp
+ rows are reversed a byte at a time, each byte having its bits or nibbles reversed
+ through a table, after which any unused bits that were at the end of the row are
+ now at its start, so the whole row is shifted left to drop them.
+ */
+static void flipHorizontally(TBitmap &bitmap)
+{
+    size_t stride = bitmapStride(bitmap);
+    
+    if (bitmap.bpp >= 8) {
+        size_t size = bitmap.bpp / 8;
+        for (int y = 0; y < bitmap.height; ++y) {
+            uint8_t *row = bitmap.bytes.data() + stride * y;
+            for (size_t left = 0, right = bitmap.width - 1; left < right; ++left, --right)
+                std::swap_ranges(row + left * size, row + (left + 1) * size, row + right * size);
+        }
+        return;
+    }
+    
+    uint8_t reversed[256];
+    for (int i = 0; i < 256; ++i) {
+        if (bitmap.bpp == 4) {
+            reversed[i] = (uint8_t)(i >> 4 | i << 4);
+            continue;
+        }
+        uint8_t bits = 0;
+        for (int n = 0; n < 8; ++n) bits |= ((i >> n) & 1) << (7 - n);
+        reversed[i] = bits;
+    }
+    
+    int unused = (int)(stride * 8 - (size_t)bitmap.width * bitmap.bpp);
+    for (int y = 0; y < bitmap.height; ++y) {
+        uint8_t *row = bitmap.bytes.data() + stride * y;
+        std::reverse(row, row + stride);
+        for (size_t i = 0; i < stride; ++i) row[i] = reversed[row[i]];
+        
+        if (unused) {
+            for (size_t i = 0; i < stride; ++i)
+                row[i] = row[i] << unused | (i + 1 < stride ? row[i + 1] >> (8 - unused) : 0);
+        }
+    }
+}
+
+// Transposes an 8x8 block of bits held a row to a byte, the first row in the most significant byte.
+static uint64_t transposeBits(uint64_t x)
+{
+    uint64_t t;
+    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+    x = x ^ t ^ (t << 28);
+    return x;
+}
+
+/*
+ Swaps the rows and columns of an image, walking both images a block at a time so
+ that the column-wise accesses stay within cache. Packed images are transposed in
+ units of a byte: 8x8 blocks of bits for 1bpp, and 2x2 blocks of nibbles for 4bpp.
+ Any rows or columns beyond the edge of the image are read as zero and not written.
+ */
+static TBitmap transpose(const TBitmap &bitmap)
+{
+    TBitmap transposed{};
+    transposed.width = bitmap.height;
+    transposed.height = bitmap.width;
+    transposed.bpp = bitmap.bpp;
+    transposed.palette = bitmap.palette;
+    transposed.bytes.resize(bitmapStride(transposed) * transposed.height);
+    
+    const size_t stride = bitmapStride(bitmap), destination = bitmapStride(transposed);
+    const uint8_t *source = bitmap.bytes.data();
+    uint8_t *bytes = transposed.bytes.data();
+    const size_t w = bitmap.width, h = bitmap.height;
+    
+    switch (bitmap.bpp) {
+        case 1:
+            for (size_t column = 0; column < stride; column += BLOCK / 8)
+            for (size_t by = 0; by < h; by += 8) {
+                for (size_t bx = column; bx < std::min<size_t>(column + BLOCK / 8, stride); ++bx) {
+                    uint64_t block = 0;
+                    for (size_t r = 0; r < 8; ++r) {
+                        block = block << 8 | (by + r < h ? source[(by + r) * stride + bx] : 0);
+                    }
+                    block = transposeBits(block);
+                    for (size_t r = 0; r < 8 && bx * 8 + r < w; ++r) {
+                        bytes[(bx * 8 + r) * destination + by / 8] = (uint8_t)(block >> (56 - r * 8));
+                    }
+                }
+            }
+            break;
+            
+        case 4:
+            for (size_t column = 0; column < stride; column += BLOCK / 2)
+            for (size_t by = 0; by < h; by += 2) {
+                for (size_t bx = column; bx < std::min<size_t>(column + BLOCK / 2, stride); ++bx) {
+                    uint8_t a = source[by * stride + bx];
+                    uint8_t b = by + 1 < h ? source[(by + 1) * stride + bx] : 0;
+                    bytes[(bx * 2) * destination + by / 2] = (a & 0xF0) | b >> 4;
+                    if (bx * 2 + 1 < w) bytes[(bx * 2 + 1) * destination + by / 2] = (uint8_t)(a << 4) | (b & 0x0F);
+                }
+            }
+            break;
+            
+        default: {
+            const size_t size = bitmap.bpp / 8;
+            for (size_t by = 0; by < h; by += BLOCK) {
+                for (size_t bx = 0; bx < w; bx += BLOCK) {
+                    for (size_t y = by; y < std::min<size_t>(by + BLOCK, h); ++y) {
+                        for (size_t x = bx; x < std::min<size_t>(bx + BLOCK, w); ++x) {
+                            std::copy_n(source + y * stride + x * size, size, bytes + x * destination + y * size);
+                        }
+                    }
+                }
+            }
+            break;
+        }
+    }
+    
+    return transposed;
+}
+
+TBitmap orientBitmap(const TBitmap &bitmap, Orientation orientation)
+{
+    if (!isSupported(bitmap) || bitmap.bytes.empty()) return TBitmap{};
+    
+    TBitmap oriented{};
+    
+    switch (orientation) {
+        case OrientationHFlip:
+            oriented = bitmap;
+            flipHorizontally(oriented);
+            break;
+            
+        case OrientationVFlip:
+            oriented = bitmap;
+            flipVertically(oriented);
+            break;
+            
+        case OrientationRot180:
+            oriented = bitmap;
+            flipHorizontally(oriented);
+            flipVertically(oriented);
+            break;
+            
+        case OrientationRot90:
+            oriented = transpose(bitmap);
+            flipHorizontally(oriented);
+            break;
+            
+        case OrientationRot270:
+            oriented = transpose(bitmap);
+            flipVertically(oriented);
+            break;
+    }
+    
+    return oriented;
+}
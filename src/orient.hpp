@@ -0,0 +1,46 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef orient_hpp
+#define orient_hpp
+
+#include "bmp.hpp"
+
+enum Orientation {
+    OrientationHFlip,
+    OrientationVFlip,
+    OrientationRot90,
+    OrientationRot180,
+    OrientationRot270
+};
+
+/**
+ @brief    Returns a copy of a bitmap image mirrored or rotated, rotations being clockwise.
+ @param    bitmap The bitmap image, of any bpp including the packed 1bpp and 4bpp.
+ @param    orientation The mirror image or rotation to be made.
+ @return   The bitmap image in the new orientation, no image data if the bpp is unsupported.
+ */
+TBitmap orientBitmap(const TBitmap &bitmap, Orientation orientation);
+
+#endif /* orient_hpp */
@@ -0,0 +1,236 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "palette.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+std::vector<size_t> paletteHistogram(const TBitmap &bitmap)
+{
+    std::vector<size_t> histogram(256);
+    std::mutex mutex;
+    
+    if (bitmap.bpp != 1 && bitmap.bpp != 4 && bitmap.bpp != 8) return histogram;
+    
+    /*
+     Each thread counts its own band of rows into a private table, the tables
+     are only merged once a band is complete so no locking is needed per pixel.
+     */
+    parallel::forRange(bitmap.height, 64, [&](size_t begin, size_t end) {
+        size_t counts[256] = {};
+        
+        for (size_t y = begin; y < end; ++y) {
+            if (bitmap.bpp == 8) {
+                const uint8_t *row = bitmap.bytes.data() + bitmapStride(bitmap) * y;
+                for (int x = 0; x < bitmap.width; ++x)
+                    counts[row[x]]++;
+                continue;
+            }
+            for (int x = 0; x < bitmap.width; ++x)
+                counts[getPixel(bitmap, x, (int)y)]++;
+        }
+        
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int i = 0; i < 256; ++i)
+            histogram[i] += counts[i];
+    });
+    
+    return histogram;
+}
+
+/*
+ Rewrites the pixels of an indexed bitmap image through the remap table, packing
+ them at the given bpp and replacing its palette.
+ */
+static void remapBitmap(TBitmap &bitmap, const uint8_t remap[256], const std::vector<uint32_t> &palette, int bpp)
+{
+    TBitmap image{};
+    image.width = bitmap.width;
+    image.height = bitmap.height;
+    image.bpp = bpp;
+    image.palette = palette;
+    image.bytes.resize(bitmapStride(image) * image.height);
+    
+    parallel::forRange(image.height, 64, [&](size_t begin, size_t end) {
+        for (int y = (int)begin; y < (int)end; ++y)
+            for (int x = 0; x < image.width; ++x)
+                setPixel(image, x, y, remap[getPixel(bitmap, x, y)]);
+    });
+    
+    bitmap = std::move(image);
+}
+
+static bool isIndexed(const TBitmap &bitmap)
+{
+    return bitmap.bpp == 1 || bitmap.bpp == 4 || bitmap.bpp == 8;
+}
+
+/*
+ Whether the image packs at the given bpp with every row filling whole bytes and
+ the image as a whole filling whole 64-bit elements, as otherwise padding would
+ be listed as pixels, or the last pixels left out.
+ */
+static bool isPackable(const TBitmap &bitmap, int bpp)
+{
+    return (size_t)bitmap.width * bpp % 8 == 0 && (size_t)bitmap.width * bitmap.height * bpp % 64 == 0;
+}
+
+/*
+ The smallest bpp able to hold the given number of colors that the image packs at.
+ Should the image pack at none of them, its bpp is left as it is where that holds
+ the colors, so that it is never made any worse.
+ */
+static int packedBpp(const TBitmap &bitmap, size_t colors)
+{
+    for (int bpp : {1, 4, 8}) {
+        if (colors <= (1u << bpp) && isPackable(bitmap, bpp)) return bpp;
+    }
+    for (int bpp : {1, 4, 8}) {
+        if (colors <= (1u << bpp) && bpp >= bitmap.bpp) return bpp;
+    }
+    return 8;
+}
+
+bool optimizePalette(TBitmap &bitmap)
+{
+    std::vector<TBitmap *> bitmaps{&bitmap};
+    return isIndexed(bitmap) && sharePalette(bitmaps);
+}
+
+bool sharePalette(const std::vector<TBitmap *> &bitmaps)
+{
+    std::vector<std::vector<size_t>> histograms;
+    
+    for (const TBitmap *bitmap : bitmaps) {
+        if (!isIndexed(*bitmap)) return false;
+        histograms.push_back(paletteHistogram(*bitmap));
+    }
+    
+    /*
+     Every palette entry in use is reduced to its color, so that entries which
+     duplicate a color, whether in the same image or in different images, are
+     merged along with their pixel counts.
+     */
+    std::vector<uint32_t> colors;
+    std::vector<size_t> counts;
+    for (size_t b = 0; b < bitmaps.size(); ++b) {
+        for (size_t index = 0; index < 256; ++index) {
+            if (!histograms[b][index]) continue;
+            
+            uint32_t color = index < bitmaps[b]->palette.size() ? bitmaps[b]->palette.at(index) : 0;
+            auto it = std::find(colors.begin(), colors.end(), color);
+            if (it == colors.end()) {
+                colors.push_back(color);
+                counts.push_back(0);
+                it = colors.end() - 1;
+            }
+            counts[it - colors.begin()] += histograms[b][index];
+        }
+    }
+    
+    if (colors.size() > 256) return false;
+    
+    // The most frequently used colors are given the lowest indices.
+    std::vector<size_t> order(colors.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return counts[a] > counts[b];
+    });
+    
+    std::vector<uint32_t> palette;
+    for (size_t i : order) palette.push_back(colors[i]);
+    
+    for (TBitmap *bitmap : bitmaps) {
+        int bpp = packedBpp(*bitmap, palette.size());
+        uint8_t remap[256] = {};
+        for (size_t index = 0; index < 256; ++index) {
+            uint32_t color = index < bitmap->palette.size() ? bitmap->palette.at(index) : 0;
+            remap[index] = std::find(palette.begin(), palette.end(), color) - palette.begin();
+        }
+        remapBitmap(*bitmap, remap, palette, bpp);
+    }
+    
+    return true;
+}
+
+bool repackBitmap(TBitmap &bitmap, int bpp)
+{
+    if (!isIndexed(bitmap) || (bpp != 1 && bpp != 4 && bpp != 8)) return false;
+    if (bitmap.palette.size() > (1u << bpp) || !isPackable(bitmap, bpp)) return false;
+    if (bitmap.bpp == bpp) return true;
+    
+    uint8_t remap[256];
+    for (int index = 0; index < 256; ++index) remap[index] = index;
+    
+    std::vector<uint32_t> palette = bitmap.palette;
+    remapBitmap(bitmap, remap, palette, bpp);
+    
+    return true;
+}
+
+bool quantizeBitmap(TBitmap &bitmap)
+{
+    if (bitmap.bpp != 32) return false;
+    
+    const size_t count = (size_t)bitmap.width * bitmap.height;
+    const uint8_t *bytes = bitmap.bytes.data();
+    
+    // Colors are held as they are in a palette, blue, green and red from the most significant byte.
+    std::unordered_map<uint32_t, uint8_t> colors;
+    std::vector<uint32_t> palette;
+    for (size_t i = 0; i < count && palette.size() <= 256; ++i) {
+        uint32_t color = (uint32_t)bytes[i * 4] << 24 | bytes[i * 4 + 1] << 16 | bytes[i * 4 + 2] << 8 | 255;
+        if (colors.emplace(color, (uint8_t)palette.size()).second) palette.push_back(color);
+    }
+    
+    TBitmap image{};
+    image.width = bitmap.width;
+    image.height = bitmap.height;
+    
+    if (palette.size() <= 256) {
+        image.bpp = 8;
+        image.palette = palette;
+        image.bytes.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t color = (uint32_t)bytes[i * 4] << 24 | bytes[i * 4 + 1] << 16 | bytes[i * 4 + 2] << 8 | 255;
+            image.bytes[i] = colors[color];
+        }
+        bitmap = std::move(image);
+        optimizePalette(bitmap);
+        return true;
+    }
+    
+    image.bpp = 16;
+    image.bytes.resize(count * 2);
+    for (size_t i = 0; i < count; ++i) {
+        uint16_t color = (bytes[i * 4 + 2] >> 3) << 10 | (bytes[i * 4 + 1] >> 3) << 5 | bytes[i * 4] >> 3;
+        image.bytes[i * 2] = color & 255;
+        image.bytes[i * 2 + 1] = color >> 8;
+    }
+    bitmap = std::move(image);
+    return true;
+}
+
@@ -0,0 +1,73 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef palette_hpp
+#define palette_hpp
+
+#include "bmp.hpp"
+
+/**
+ @brief    Counts how many pixels use each palette index of an indexed (1, 4 or 8 bpp) bitmap image.
+ @param    bitmap The bitmap image to be analysed.
+ @return   A table of 256 pixel counts, one for each possible palette index.
+ */
+std::vector<size_t> paletteHistogram(const TBitmap &bitmap);
+
+/**
+ @brief    Removes unused and duplicate palette entries from an indexed bitmap image, orders the
+           remaining entries by frequency and repacks the pixel data at the smallest bit depth
+           (1, 4 or 8 bpp) able to hold the palette, leaving the artwork itself unchanged. A bit
+           depth is only used if every row fills whole bytes and the image whole 64-bit elements.
+ @param    bitmap The bitmap image to be optimized.
+ @return   true if the bitmap image was indexed and has been optimized.
+ */
+bool optimizePalette(TBitmap &bitmap);
+
+/**
+ @brief    Builds a single palette of the colors used across several indexed bitmap images,
+           ordered by frequency, and remaps every image to it. Each image is repacked at the
+           smallest bit depth (1, 4 or 8 bpp) able to hold the shared palette that it packs at.
+ @param    bitmaps The bitmap images to share a palette.
+ @return   true if every bitmap image was indexed and together they use no more than 256 colors.
+ */
+bool sharePalette(const std::vector<TBitmap *> &bitmaps);
+
+/**
+ @brief    Repacks the pixel data of an indexed bitmap image at a different bit depth.
+ @param    bitmap The bitmap image to be repacked.
+ @param    bpp The bit depth required, 1, 4 or 8.
+ @return   true if the bitmap image is indexed, its palette fits the bit depth required and it
+           packs into whole bytes per row and whole 64-bit elements at that bit depth.
+ */
+bool repackBitmap(TBitmap &bitmap, int bpp);
+
+/**
+ @brief    Reduces a 32bpp bitmap image to an indexed image when it uses no more than 256 colors,
+           at the smallest bit depth able to hold them, otherwise to 16bpp (RGB555). The alpha
+           channel is discarded.
+ @param    bitmap The bitmap image to be quantized.
+ @return   true if the bitmap image was 32bpp and has been quantized.
+ */
+bool quantizeBitmap(TBitmap &bitmap);
+
+#endif /* palette_hpp */
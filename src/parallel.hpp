@@ -0,0 +1,139 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef parallel_hpp
+#define parallel_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+    /**
+     @brief    Splits the range [0, count) into contiguous chunks and calls fn(begin, end) for each
+               chunk on its own thread, returning once every chunk has been processed.
+     @param    count The number of items in the range.
+     @param    grain The smallest number of items worth handing to a thread of its own.
+     @param    fn The function to be called for each chunk.
+     */
+    template <typename F> void forRange(size_t count, size_t grain, F fn) {
+        size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        threads = std::min(threads, count / std::max<size_t>(grain, 1));
+        
+        if (threads < 2) {
+            if (count) fn(size_t(0), count);
+            return;
+        }
+        
+        std::vector<std::thread> workers;
+        size_t chunk = (count + threads - 1) / threads;
+        for (size_t begin = 0; begin < count; begin += chunk) {
+            workers.emplace_back(fn, begin, std::min(begin + chunk, count));
+        }
+        for (auto &worker : workers) worker.join();
+    }
+    
+    /**
+     @brief    Calls fn(index, worker) for every index of the range [0, count), handing out the
+               next index to whichever thread is free first, so that items that take longer, such
+               as larger files, do not hold back the others. Returns once every item is done.
+     @param    count The number of items in the range.
+     @param    threads The number of threads to use, each is given its own worker number below it.
+     @param    fn The function to be called for each item, returning false to stop handing out more.
+     */
+    template <typename F> void forEach(size_t count, size_t threads, F fn) {
+        threads = std::clamp<size_t>(threads, 1, std::max<size_t>(count, 1));
+        std::atomic<size_t> next{0};
+        std::atomic<bool> stop{false};
+        
+        auto work = [&](size_t worker) {
+            for (size_t index; !stop && (index = next++) < count; ) {
+                if (!fn(index, worker)) stop = true;
+            }
+        };
+        
+        std::vector<std::thread> workers;
+        for (size_t worker = 1; worker < threads; ++worker) {
+            workers.emplace_back(work, worker);
+        }
+        work(0);
+        for (auto &worker : workers) worker.join();
+    }
+    
+    /**
+     @brief    A queue of bounded depth between the stages of a pipeline. Pushing blocks while the
+               queue is full and popping blocks while it is empty, so the stages run side by side
+               without one running ahead and holding more than the depth in memory.
+     */
+    template <typename T> class Queue {
+    public:
+        explicit Queue(size_t depth) : depth(std::max<size_t>(depth, 1)) {}
+        
+        void push(T item) {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return items.size() < depth; });
+            items.push_back(std::move(item));
+            changed.notify_all();
+        }
+        
+        // Returns false once the queue is both closed and empty.
+        bool pop(T &item) {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return !items.empty() || closed; });
+            if (items.empty()) return false;
+            item = std::move(items.front());
+            items.pop_front();
+            changed.notify_all();
+            return true;
+        }
+        
+        // Returns false straight away should the queue be empty.
+        bool tryPop(T &item) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (items.empty()) return false;
+            item = std::move(items.front());
+            items.pop_front();
+            changed.notify_all();
+            return true;
+        }
+        
+        void close() {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+            changed.notify_all();
+        }
+        
+    private:
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<T> items;
+        size_t depth;
+        bool closed = false;
+    };
+}
+
+#endif /* parallel_hpp */
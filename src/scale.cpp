@@ -0,0 +1,234 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#include "scale.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+/*
+ The contribution of source pixels to each destination pixel along one axis, as
+ the first source pixel and the weights of it and the pixels that follow it. The
+ weights of every destination pixel take up the same number of entries, padded
+ with zeros, so that they can be looked up without a further table.
+ */
+typedef struct {
+    std::vector<int> first;
+    std::vector<int> taps;
+    std::vector<float> weights;
+    int stride;
+} TFilter;
+
+static TFilter buildFilter(int source, int destination)
+{
+    TFilter filter{};
+    double scale = (double)source / destination;
+    
+    filter.stride = source > destination ? (int)std::ceil(scale) + 1 : 2;
+    filter.first.resize(destination);
+    filter.taps.resize(destination);
+    filter.weights.resize((size_t)destination * filter.stride);
+    
+    for (int i = 0; i < destination; ++i) {
+        float *weights = &filter.weights[(size_t)i * filter.stride];
+        
+        if (source > destination) {
+            // Box, each source pixel is weighted by how much of it the destination pixel covers.
+            double left = i * scale, right = (i + 1) * scale;
+            int first = (int)left, last = std::min((int)std::ceil(right), source);
+            filter.first[i] = first;
+            filter.taps[i] = last - first;
+            for (int j = first; j < last; ++j) {
+                weights[j - first] = (float)((std::min<double>(j + 1, right) - std::max<double>(j, left)) / scale);
+            }
+            continue;
+        }
+        
+        // Bilinear, between the two source pixels whose centers surround that of the destination pixel.
+        double x = (i + 0.5) * scale - 0.5;
+        int first = (int)std::floor(x);
+        float fraction = (float)(x - first);
+        if (first < 0) {
+            filter.first[i] = 0;
+            filter.taps[i] = 1;
+            weights[0] = 1.0f;
+        } else if (first + 1 >= source) {
+            filter.first[i] = source - 1;
+            filter.taps[i] = 1;
+            weights[0] = 1.0f;
+        } else {
+            filter.first[i] = first;
+            filter.taps[i] = 2;
+            weights[0] = 1.0f - fraction;
+            weights[1] = fraction;
+        }
+    }
+    
+    return filter;
+}
+
+// Unpacks the pixels of a row of a 16bpp or 32bpp image into four channels of floats.
+static void unpackRow(const TBitmap &bitmap, int y, float *channels)
+{
+    const uint8_t *bytes = bitmap.bytes.data() + bitmapStride(bitmap) * y;
+    
+    if (bitmap.bpp == 32) {
+        for (int i = 0; i < bitmap.width * 4; ++i) channels[i] = bytes[i];
+        return;
+    }
+    
+    for (int x = 0; x < bitmap.width; ++x) {
+        uint16_t color = bytes[x * 2] | bytes[x * 2 + 1] << 8;
+        channels[x * 4 + 0] = color & 31;
+        channels[x * 4 + 1] = color >> 5 & 31;
+        channels[x * 4 + 2] = color >> 10 & 31;
+        channels[x * 4 + 3] = color >> 15;
+    }
+}
+
+// Packs a row of four channels of floats back into the pixels of a 16bpp or 32bpp image, rounding each channel.
+static void packRow(TBitmap &bitmap, int y, const float *channels)
+{
+    uint8_t *bytes = bitmap.bytes.data() + bitmapStride(bitmap) * y;
+    
+    if (bitmap.bpp == 32) {
+        for (int i = 0; i < bitmap.width * 4; ++i) bytes[i] = (uint8_t)std::clamp(channels[i] + 0.5f, 0.0f, 255.0f);
+        return;
+    }
+    
+    for (int x = 0; x < bitmap.width; ++x) {
+        uint16_t color = (uint16_t)std::clamp(channels[x * 4 + 0] + 0.5f, 0.0f, 31.0f);
+        color |= (uint16_t)std::clamp(channels[x * 4 + 1] + 0.5f, 0.0f, 31.0f) << 5;
+        color |= (uint16_t)std::clamp(channels[x * 4 + 2] + 0.5f, 0.0f, 31.0f) << 10;
+        color |= (uint16_t)std::clamp(channels[x * 4 + 3] + 0.5f, 0.0f, 1.0f) << 15;
+        bytes[x * 2] = color & 0xFF;
+        bytes[x * 2 + 1] = color >> 8;
+    }
+}
+
+/*
+ Resamples in two passes, first each row of the source to the new width, then each
+ row of the result to the new height. Both passes only ever add a weighted row of
+ floats to another, a loop the compiler vectorizes, and each row is independent of
+ every other, so rows are resampled in parallel.
+ */
+static void resampleColor(const TBitmap &bitmap, TBitmap &scaled)
+{
+    TFilter horizontal = buildFilter(bitmap.width, scaled.width);
+    TFilter vertical = buildFilter(bitmap.height, scaled.height);
+    size_t source = (size_t)bitmap.width * 4, destination = (size_t)scaled.width * 4;
+    std::vector<float> rows((size_t)bitmap.height * destination);
+    
+    parallel::forRange(bitmap.height, 16, [&](size_t begin, size_t end) {
+        std::vector<float> channels(source);
+        for (size_t y = begin; y < end; ++y) {
+            unpackRow(bitmap, (int)y, channels.data());
+            float *row = &rows[y * destination];
+            for (int x = 0; x < scaled.width; ++x) {
+                const float *weights = &horizontal.weights[(size_t)x * horizontal.stride];
+                const float *pixel = &channels[(size_t)horizontal.first[x] * 4];
+                float sum[4] = {};
+                for (int k = 0; k < horizontal.taps[x]; ++k, pixel += 4) {
+                    for (int c = 0; c < 4; ++c) sum[c] += weights[k] * pixel[c];
+                }
+                for (int c = 0; c < 4; ++c) row[x * 4 + c] = sum[c];
+            }
+        }
+    });
+    
+    parallel::forRange(scaled.height, 16, [&](size_t begin, size_t end) {
+        std::vector<float> sum(destination);
+        for (size_t y = begin; y < end; ++y) {
+            std::fill(sum.begin(), sum.end(), 0.0f);
+            const float *weights = &vertical.weights[y * vertical.stride];
+            for (int k = 0; k < vertical.taps[y]; ++k) {
+                const float *row = &rows[(size_t)(vertical.first[y] + k) * destination];
+                const float weight = weights[k];
+                for (size_t i = 0; i < destination; ++i) sum[i] += weight * row[i];
+            }
+            packRow(scaled, (int)y, sum.data());
+        }
+    });
+}
+
+/*
+ For indexed images the source column of each destination column is looked up
+ once, then every row is gathered through it, with 8bpp rows copied byte by byte
+ and the packed 1bpp and 4bpp rows a pixel at a time.
+ */
+static void resampleIndexed(const TBitmap &bitmap, TBitmap &scaled)
+{
+    std::vector<int> columns(scaled.width);
+    for (int x = 0; x < scaled.width; ++x) {
+        columns[x] = (int)(((int64_t)x * 2 + 1) * bitmap.width / (2 * scaled.width));
+    }
+    
+    parallel::forRange(scaled.height, 16, [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y) {
+            int sy = (int)(((int64_t)y * 2 + 1) * bitmap.height / (2 * scaled.height));
+            if (bitmap.bpp == 8) {
+                const uint8_t *source = bitmap.bytes.data() + bitmapStride(bitmap) * sy;
+                uint8_t *row = scaled.bytes.data() + bitmapStride(scaled) * y;
+                for (int x = 0; x < scaled.width; ++x) row[x] = source[columns[x]];
+                continue;
+            }
+            for (int x = 0; x < scaled.width; ++x) {
+                setPixel(scaled, x, (int)y, getPixel(bitmap, columns[x], sy));
+            }
+        }
+    });
+}
+
+TBitmap scaleBitmap(const TBitmap &bitmap, int width, int height)
+{
+    TBitmap scaled{};
+    
+    if (bitmap.bytes.empty() || width < 1 || height < 1 || width > 0xFFFF || height > 0xFFFF) return scaled;
+    
+    scaled.width = width;
+    scaled.height = height;
+    scaled.bpp = bitmap.bpp;
+    scaled.palette = bitmap.palette;
+    
+    switch (bitmap.bpp) {
+        case 1:
+        case 4:
+        case 8:
+            scaled.bytes.resize(bitmapStride(scaled) * height);
+            resampleIndexed(bitmap, scaled);
+            break;
+            
+        case 16:
+        case 32:
+            scaled.bytes.resize(bitmapStride(scaled) * height);
+            resampleColor(bitmap, scaled);
+            break;
+            
+        default:
+            break;
+    }
+    
+    return scaled;
+}
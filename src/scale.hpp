@@ -0,0 +1,42 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef scale_hpp
+#define scale_hpp
+
+#include "bmp.hpp"
+
+/**
+ @brief    Resamples a bitmap image to a new size. Indexed images are resampled by nearest
+           neighbour, so that only colors of the palette are used, while 16bpp and 32bpp images
+           are averaged over the area each pixel covers when made smaller, and bilinearly
+           interpolated when made larger.
+ @param    bitmap The bitmap image to be resampled.
+ @param    width The width of the resampled image.
+ @param    height The height of the resampled image.
+ @return   The resampled bitmap image at the same bpp, no image data if the bpp is unsupported.
+ */
+TBitmap scaleBitmap(const TBitmap &bitmap, int width, int height);
+
+#endif /* scale_hpp */
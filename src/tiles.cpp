@@ -0,0 +1,143 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "tiles.hpp"
+#include "parallel.hpp"
+
+#include <unordered_map>
+
+typedef struct {
+    std::vector<uint32_t> pixels;
+    uint64_t hash;
+    uint16_t flags;
+} TTile;
+
+static std::vector<uint32_t> extractTile(const TBitmap &bitmap, int left, int top, int width, int height, uint16_t flags)
+{
+    std::vector<uint32_t> pixels(width * height);
+    
+    for (int y = 0; y < height; ++y) {
+        int sy = top + (flags & TILE_VFLIP ? height - 1 - y : y);
+        for (int x = 0; x < width; ++x) {
+            int sx = left + (flags & TILE_HFLIP ? width - 1 - x : x);
+            // Tiles that overhang the edge of the image are padded with zero.
+            if (sx < bitmap.width && sy < bitmap.height)
+                pixels[x + y * width] = getPixel(bitmap, sx, sy);
+        }
+    }
+    return pixels;
+}
+
+static uint64_t hashTile(const std::vector<uint32_t> &pixels)
+{
+    // FNV-1a
+    uint64_t hash = 0xCBF29CE484222325;
+    for (uint32_t pixel : pixels) {
+        hash ^= pixel;
+        hash *= 0x100000001B3;
+    }
+    return hash;
+}
+
+TTilemap buildTilemap(const TBitmap &bitmap, int width, int height, bool flips)
+{
+    TTilemap tilemap{};
+    
+    tilemap.columns = (bitmap.width + width - 1) / width;
+    tilemap.rows = (bitmap.height + height - 1) / height;
+    
+    std::vector<TTile> tiles(tilemap.columns * tilemap.rows);
+    
+    /*
+     Extracting and hashing each tile is independent of every other tile, so this
+     is done in parallel a row of tiles at a time. When mirror images are treated
+     as copies, each tile is stored in whichever of its orientations orders first,
+     so that all mirror images of a tile share the same pixels and hash.
+     */
+    parallel::forRange(tilemap.rows, 4, [&](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; ++row) {
+            for (int column = 0; column < tilemap.columns; ++column) {
+                TTile &tile = tiles[column + row * tilemap.columns];
+                tile.pixels = extractTile(bitmap, column * width, (int)row * height, width, height, 0);
+                
+                if (flips) {
+                    for (uint16_t flags : {TILE_HFLIP, TILE_VFLIP, TILE_HFLIP | TILE_VFLIP}) {
+                        std::vector<uint32_t> pixels = extractTile(bitmap, column * width, (int)row * height, width, height, flags);
+                        if (pixels < tile.pixels) {
+                            tile.pixels = std::move(pixels);
+                            tile.flags = flags;
+                        }
+                    }
+                }
+                
+                tile.hash = hashTile(tile.pixels);
+            }
+        }
+    });
+    
+    /*
+     Unique tiles are numbered in the order they are first seen, so the result
+     does not depend on how the work above was shared between threads.
+     */
+    std::unordered_multimap<uint64_t, uint16_t> seen;
+    std::vector<const TTile *> unique;
+    
+    for (const TTile &tile : tiles) {
+        int index = -1;
+        auto range = seen.equal_range(tile.hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (unique[it->second]->pixels == tile.pixels) {
+                index = it->second;
+                break;
+            }
+        }
+        if (index < 0) {
+            index = (int)unique.size();
+            seen.emplace(tile.hash, index);
+            unique.push_back(&tile);
+        }
+        tilemap.map.push_back(index | tile.flags);
+    }
+    
+    /*
+     A bitmap image can be no taller than 65535 pixels, and an index must stay clear
+     of the bits used for TILE_HFLIP and TILE_VFLIP.
+     */
+    if ((size_t)height * unique.size() > 0xFFFF || unique.size() > TILE_INDEX + 1) {
+        return tilemap;
+    }
+    
+    tilemap.tileset.width = width;
+    tilemap.tileset.height = height * unique.size();
+    tilemap.tileset.bpp = bitmap.bpp;
+    tilemap.tileset.palette = bitmap.palette;
+    tilemap.tileset.bytes.resize(bitmapStride(tilemap.tileset) * tilemap.tileset.height);
+    
+    for (size_t i = 0; i < unique.size(); ++i) {
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x)
+                setPixel(tilemap.tileset, x, (int)i * height + y, unique[i]->pixels[x + y * width]);
+    }
+    
+    return tilemap;
+}
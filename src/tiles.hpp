@@ -0,0 +1,53 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef tiles_hpp
+#define tiles_hpp
+
+#include "bmp.hpp"
+
+#define TILE_INDEX 0x3FFF
+#define TILE_HFLIP 0x4000
+#define TILE_VFLIP 0x8000
+
+typedef struct {
+    TBitmap tileset;
+    uint16_t columns;
+    uint16_t rows;
+    std::vector<uint16_t> map;
+} TTilemap;
+
+/**
+ @brief    Splits a bitmap image into tiles, keeping only one copy of each unique tile.
+ @param    bitmap The bitmap image to be split into tiles.
+ @param    width The width of a tile.
+ @param    height The height of a tile.
+ @param    flips Whether a tile that is a mirror image of another is also treated as a copy.
+ @return   The unique tiles stacked vertically in a single bitmap image, and for each tile of the
+           image the index of its unique tile, combined with TILE_HFLIP and TILE_VFLIP should the
+           unique tile need to be mirrored to match. No tileset if the unique tiles would not fit
+           in a single image, or number more than TILE_INDEX + 1.
+ */
+TTilemap buildTilemap(const TBitmap &bitmap, int width, int height, bool flips);
+
+#endif /* tiles_hpp */
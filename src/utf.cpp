@@ -224,6 +224,44 @@ size_t utf::write(std::ofstream& os, const std::wstring& wstr, BOM bom) {
 }
 
 
+size_t utf::encode(const std::string& str, std::string& buffer, BOM bom) {
+    buffer.clear();
+    if (str.empty()) return 0;
+    
+    if (bom == BOMle) buffer.append("\xFF\xFE", 2);
+    if (bom == BOMbe) buffer.append("\xFE\xFF", 2);
+    
+    size_t length = buffer.size();
+    buffer.resize(length + str.length() * 2);
+    uint8_t *out = (uint8_t *)buffer.data() + length;
+    
+    for (size_t n = 0; n < str.length(); n++) {
+        uint8_t ascii = (uint8_t)str[n];
+        if (ascii == '\r') continue;
+        
+        uint16_t utf16 = ascii;
+        if (ascii >= 0x80) {
+            // Only 2 and 3-byte sequences map to a single UTF-16 character, anything else is skipped.
+            size_t extra = (ascii & 0b11100000) == 0b11000000 ? 1 : (ascii & 0b11110000) == 0b11100000 ? 2 : 0;
+            if (!extra || n + extra >= str.length()) continue;
+            utf16 = convertUTF8ToUTF16(&str[n]);
+            n += extra;
+        }
+        
+        if (bom == BOMbe) {
+            *out++ = utf16 >> 8;
+            *out++ = utf16 & 0xFF;
+        } else {
+            *out++ = utf16 & 0xFF;
+            *out++ = utf16 >> 8;
+        }
+    }
+    
+    buffer.resize(out - (uint8_t *)buffer.data());
+    return buffer.size();
+}
+
+
 bool utf::save(const std::filesystem::path& path, const std::string& str) {
     std::ofstream os;
     
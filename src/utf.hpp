@@ -43,6 +43,9 @@ namespace utf {
     std::wstring load(const std::filesystem::path& path, BOM bom = BOMle);
     size_t write(std::ofstream& os, const std::string& str);
     size_t write(std::ofstream& os, const std::wstring& wstr, BOM bom = BOMle);
+    
+    // Encodes UTF-8 text as UTF-16 into a buffer that is reused, ready to be saved as is.
+    size_t encode(const std::string& str, std::string& buffer, BOM bom = BOMle);
     bool save(const std::filesystem::path& path, const std::string& str);
     bool save(const std::filesystem::path& path, const std::wstring& wstr, BOM bom = BOMle);
 };